@@ -27,11 +27,11 @@ private:
     std::map<int, DFGNode*> _nodes;   // <node-id, node>
     std::map<int, DFGEdge*> _edges;   // <edge-id, edge>
 
-    // depth-first search, sort dfg nodes in topological order
+    // depth-first search, sort dfg nodes in topological order, back edges are ignored
     void dfs(DFGNode* node, std::map<int, bool>& visited);
 
 protected:
-    // DFG nodes in topological order, DFG should be DAG
+    // DFG nodes in topological order, DFG should be DAG except the back edges
     std::vector<DFGNode*> _topoNodes;
 
     // // max latency mismatch among the operands of one DFG node
@@ -82,6 +82,8 @@ public:
     void addEdge(DFGEdge* edge);
     void delNode(int id);
     void delEdge(int id);
+    // if there are back edges (loop-carried dependences)
+    bool hasBackEdge();
 
     // DFG nodes in topological order
     const std::vector<DFGNode*>& topoNodes(){ return _topoNodes; }
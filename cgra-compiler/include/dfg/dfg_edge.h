@@ -16,6 +16,7 @@ private:
     int _dstPortIdx; // destination node I/O port index
     int _srcId;   // source node ID
     int _dstId;   // destination node ID
+    int _iterDist = 0; // iteration distance of the loop-carried dependence, 0: intra-iteration edge
 public:
     DFGEdge(){}
     DFGEdge(int edgeId){ _id = edgeId; }
@@ -31,6 +32,10 @@ public:
     void setSrcId(int srcId){ _srcId = srcId; }
     int dstId(){ return _dstId; }
     void setDstId(int dstId){ _dstId = dstId; }
+    int iterDist(){ return _iterDist; }
+    void setIterDist(int iterDist){ _iterDist = iterDist; }
+    // back edge: loop-carried dependence, the destination node uses the value of the former iteration
+    bool isBackEdge(){ return _iterDist > 0; }
     void setEdge(int srcId, int dstId){
         _srcId = srcId;
         _dstId = dstId;
@@ -9,6 +9,13 @@
 #include "op/operations.h"
 
 
+// region constraint of the DFG node, bounding box of the locations of the GPE nodes
+struct DFGNodeRegion
+{
+    int minX, minY, maxX, maxY;
+};
+
+
 class DFGNode
 {
 private:
@@ -16,7 +23,7 @@ private:
     std::string _name;
     std::string _type;
     std::string _operation;
-    int _bitWidth;
+    int _bitWidth = 0; // 0: not specified
     // int _numInputs;
     // int _numOutputs;
     int _opLatency = 1; // operation latency
@@ -27,6 +34,8 @@ private:
     std::map<int, std::set<std::pair<int, int>>> _outputs; // <output-index, set<node-id, node-port-idx>>
     std::map<int, int> _inputEdges; // <input-index, edge-id>
     std::map<int, std::set<int>> _outputEdges; // <output-index, set<edge-id>>
+    bool _hasRegion = false; // if the node can only be mapped to the GPE nodes in the region
+    DFGNodeRegion _region;
 public:
     DFGNode(){}
     ~DFGNode(){}
@@ -54,6 +63,13 @@ public:
     int immIdx(){ return _immIdx; }
     void setImmIdx(int immIdx){ _immIdx = immIdx; }
     bool hasImm(){ return _immIdx >= 0; }
+    bool hasRegion(){ return _hasRegion; }
+    const DFGNodeRegion& region(){ return _region; }
+    void setRegion(const DFGNodeRegion& region){ _region = region; _hasRegion = true; }
+    // if the location (x, y) is in the region, true if no region constraint
+    bool inRegion(int x, int y){ 
+        return !_hasRegion || (x >= _region.minX && x <= _region.maxX && y >= _region.minY && y <= _region.maxY); 
+    }
     const std::map<int, std::pair<int, int>>& inputs(){ return _inputs; }
     const std::map<int, std::set<std::pair<int, int>>>& outputs(){ return _outputs; }
     std::pair<int, int> input(int index); // return <node-id, node-port-idx>
@@ -0,0 +1,98 @@
+#ifndef __DFG_TRANSFORM_H__
+#define __DFG_TRANSFORM_H__
+
+#include <functional>
+#include "dfg/dfg.h"
+#include "adg/adg.h"
+
+
+// Tree-height reduction
+// rebalance the chains of commutative and associative operations (e.g. ADD, MUL) into balanced trees
+// chain: the nodes with the same operation and bit-width, each non-root node has only one consumer in the chain
+// the operands of the chain are combined in the order of their arrival time (ASAP),
+// the node IDs of the chain are reused and the root node keeps its ID and outputs
+// return true if the DFG is modified
+bool reduceTreeHeight(DFG* dfg);
+
+// Constant propagation and folding
+// constant node: no input edge, one immediate operand, e.g. PASS(imm)
+// absorb the constant node into the consumers without immediate operand,
+// fold the node whose operands are all constant into a constant node
+// return true if the DFG is modified
+bool foldConstants(DFG* dfg, int bitWidth);
+
+// Algebraic simplification of the nodes with immediate operand
+// x+0, x-0, x*1, x|0, x^0, x&-1, x<<0, x>>0 => x; x*0, x&0 => 0;
+// x*2^k => x<<k if shlPreferred
+// return true if the DFG is modified
+bool simplifyAlgebra(DFG* dfg, int bitWidth, bool shlPreferred);
+
+// Common-subexpression elimination
+// merge the nodes with the same operation, immediate operand and inputs
+// return true if the DFG is modified
+bool eliminateCommonSubexpr(DFG* dfg);
+
+// Dead-node elimination
+// delete the nodes that cannot reach any DFG output port
+// return true if the DFG is modified
+bool eliminateDeadNodes(DFG* dfg);
+
+// DFG replication
+// copy the DFG several times into one DFG, each copy has its own nodes, edges and I/O ports
+// copy i: node ID + i * max-node-ID, edge ID + i * (max-edge-ID + 1), I/O index + i * (max-I/O-index + 1),
+// the names in copy i (i > 0) are suffixed with "_r<i>"
+// return the new DFG, deleted outside
+DFG* replicateDfg(DFG* dfg, int copies);
+
+// DFG merging
+// merge the independent DFGs into one DFG, each DFG keeps its own nodes, edges and I/O ports
+// the node IDs, edge IDs and I/O indexes of DFG k follow the ones of DFG k-1,
+// the names in DFG k (k > 0) are suffixed with "_m<k>"
+// return the new DFG, deleted outside
+DFG* mergeDfgs(const std::vector<DFG*>& dfgs);
+
+// Temporal partitioning
+// split the DFG (without back edges) into a sequence of sub-DFGs mapped to the ADG one after another,
+// each sub-DFG fits the I/O ports, the GPE nodes and the GPE nodes supporting each operation,
+// fillRatio: ratio of the GPE nodes that can be used by one sub-DFG
+// the nodes are added to the current sub-DFG in topological order, preferring the ones fed by it to reduce the cut edges
+// the value carried between sub-DFGs is the output of the former sub-DFG and the input of the latter ones,
+// named after the DFG output port it drives or the src node (suffixed with "_<port-idx>" if port-idx > 0)
+// return the sub-DFGs in execution order, deleted outside; empty if some node cannot fit
+std::vector<DFG*> partitionDfg(DFG* dfg, ADG* adg, double fillRatio = 1.0);
+
+
+// Spatial partitioning
+// split the DFG (without back edges) across at most numArrays ADG instances joined by their I/O ports,
+// each sub-DFG is mapped to one ADG instance and fits its I/O ports, GPE nodes and GPE nodes supporting each operation,
+// the values only flow from the former sub-DFGs to the latter ones and are named as in the temporal partitioning,
+// the cut cost is minimized, i.e. the cut values weighted by the latency they add to the critical path,
+// weight: 1 + max(0, interLat - slack), interLat: latency between two ADG instances, slack: ALAP - ASAP - 1 of the edge
+// return the sub-DFGs in data-flow order, deleted outside; empty if the DFG cannot fit
+std::vector<DFG*> partitionDfgSpatial(DFG* dfg, ADG* adg, int numArrays, int interLat = 2, double fillRatio = 1.0);
+
+// DFG optimization pass, return true if the DFG is modified
+typedef std::function<bool(DFG*)> DFGPass;
+
+// Pass manager of the pre-mapping DFG optimizations
+// run the passes in order and repeat the pipeline until no pass modifies the DFG
+class DFGPassManager
+{
+private:
+    std::vector<std::pair<std::string, DFGPass>> _passes; // <pass-name, pass>
+    int _maxRounds; // max rounds of the pipeline
+public:
+    DFGPassManager(int maxRounds = 8) : _maxRounds(maxRounds) {}
+    ~DFGPassManager(){}
+    int numPasses(){ return _passes.size(); }
+    void addPass(const std::string& name, DFGPass pass){ _passes.push_back(std::make_pair(name, pass)); }
+    // add the simplification, folding, CSE and DCE passes,
+    // ADG: the data width and the supported operations
+    void addDefaultPasses(ADG* adg);
+    // run the pipeline, return true if the DFG is modified
+    bool run(DFG* dfg);
+};
+
+
+
+#endif
@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <chrono>
 #include "mapper/mapping.h"
+#include "mapper/route_template.h"
 // #include "mapper/candidate.h"
 #include "mapper/visualize.h"
 #include "mapper/configuration.h"
@@ -24,10 +25,18 @@ private:
     // std::map<int, int> _adgNodeId2Idx;
     // // distances among ADG nodes
     // std::vector<std::vector<int>> _adgNodeDist; // [node-idx][node-idx]
-    // shortest distance between two ADG nodes (GPE nodes)
-    std::map<std::pair<int, int>, int> _adgNode2NodeDist; // <<node-id, node-id>, dist>
+    // map non-GIB ADG node id to continuous index starting from 0
+    std::map<int, int> _adgNodeId2Idx;
+    // shortest distance among non-GIB ADG nodes (GPE/IOB nodes), only routing through GIB nodes
+    std::vector<std::vector<int>> _adgNodeDist; // [node-idx][node-idx]
+    // GPE tiles of TILE_SIZE x TILE_SIZE GPE nodes, <<tile-col, tile-row>, GPE node IDs>
+    std::map<std::pair<int, int>, std::vector<int>> _gpeTiles;
+    // <GPE node ID, <tile-col, tile-row>>
+    std::map<int, std::pair<int, int>> _gpeNodeTile;
     // shortest distance between ADG node (GPE node) and the ADG IO
     // std::map<int, std::pair<int, int>> _adgNode2IODist; // <node-id, <2input-dist, 2output-dist>>
+    // precomputed route templates of the ADG
+    RouteTemplates* _routeTemplates = nullptr;
 
 protected:
     Mapping* _mapping = nullptr;
@@ -35,11 +44,21 @@ protected:
     double _timeout; 
     // mapping start time point
     std::chrono::time_point<std::chrono::steady_clock> _start;
+    // initiation interval of the DFG with back edges
+    int _ii = 1;
     // number of the candidate mapping ADG nodes of each DFG node in the _mapping->dfg
     // std::map<int, int> candidatesCnt; // <dfgnode-id, count>
     // std::map<int, std::vector<ADGNode*>> candidates; // <dfgnode-id, vector<adgnode>>
     // the DFG node IDs in placing order
     std::vector<int> dfgNodeIdPlaceOrder;
+    // slack of the DFG nodes, ALAP - ASAP latency ignoring the routing latency, 0: on the critical path
+    std::map<int, int> _dfgNodeSlack; // <dfgnode-id, slack>
+    // slack of the DFG edges, ALAP latency of the dst node - output latency of the src node at ASAP
+    std::map<int, int> _dfgEdgeSlack; // <edge-id, slack>, not including the back edges
+    const int TILE_SIZE = 4; // GPE tile size (GPE number in each row/column)
+    const int LARGE_ARRAY_GPES = 256; // arrays with more GPE nodes are placed tile by tile
+    const int MAX_II_SLACK = 8; // max II over the RecMII tried by the modulo mapping
+    const int CRIT_SLACK = 2; // the DFG edges with smaller slack are weighted more in the distance cost
 
 public:
     // Mapper(){}
@@ -53,10 +72,14 @@ public:
     // set modified DFG and delete the old one
     void setDfgModified(DFG* dfg);
     // if DFG is inserted passthrough nodes 
-    bool isDfgModified(){ return _dfgModified; } 
+    bool isDfgModified(){ return _isDfgModified; } 
     // set ADG and initialize ADG
     // void setADG(ADG* adg);
     ADG* getADG(){ return _adg; }
+    int getII(){ return _ii; }
+    RouteTemplates* getRouteTemplates(){ return _routeTemplates; }
+    // mapping status, the result of the last execution if succeeded
+    Mapping* getMapping(){ return _mapping; }
     // initialize mapping status of ADG
     void initializeAdg();
     // initialize mapping status of DFG
@@ -65,15 +88,30 @@ public:
     void calAdgNodeDist();
     // get the shortest distance between two ADG nodes
     int getAdgNodeDist(int srcId, int dstId);
+    // divide the GPE nodes into tiles according to their locations
+    void calGpeTiles();
+    const std::map<std::pair<int, int>, std::vector<int>>& gpeTiles(){ return _gpeTiles; }
+    // tile of the GPE node
+    std::pair<int, int> gpeNodeTile(int id){ return _gpeNodeTile[id]; }
+    // if the ADG is too large to be placed flatly
+    bool isLargeAdg(){ return _gpeNodeTile.size() > LARGE_ARRAY_GPES; }
     // // get the shortest distance between ADG node and ADG input
     // int getAdgNode2InputDist(int id);
     // // get the shortest distance between ADG node and ADG input
     // int getAdgNode2OutputDist(int id);
     // initialize candidates of DFG nodes
     // void initializeCandidates();
+    // if the DFG node can be mapped to the ADG node, i.e. the GPE node supporting its operation in its region
+    bool isCapable(DFGNode* dfgNode, ADGNode* adgNode);
     // calculate the number of the candidates for one DFG node
     int calCandidatesCnt(DFGNode* dfgNode, int maxCandidates);
+    // calculate the ASAP/ALAP latency and the slack of the DFG nodes and edges, ignoring the routing latency
+    void calDfgSlack();
+    int dfgNodeSlack(int id){ return _dfgNodeSlack[id]; }
+    // criticality weight of the DFG edge in the distance cost, 1 + max(0, CRIT_SLACK - slack), 1 for the back edges
+    int edgeCritWeight(int id);
     // sort the DFG node IDs in placing order
+    // topological order, then the tightly constrained nodes (fewer candidates) and the critical nodes (less slack) first
     void sortDfgNodeInPlaceOrder();
 
     // timestamp functions
@@ -86,15 +124,24 @@ public:
     
     // check if the DFG can be mapped to the ADG according to the resources
     bool preMapCheck(ADG* adg, DFG* dfg);
+    // max number of the DFG copies that can be mapped to the ADG according to the resources
+    int maxCopies(ADG* adg, DFG* dfg);
+    // min initiation interval limited by the recurrence cycles (RecMII), not considering the routing latency
+    // the cycle latency cannot exceed the II times the iteration distances of its back edges
+    int calRecMII(DFG* dfg);
     // map the DFG to the ADG
     virtual bool mapper() = 0;
+    // map the DFG with back edges, increase the II from the RecMII until mapped
+    // each II tries half of the remaining time, the last one tries all
+    bool mapperModulo();
     // mapper with running time
     bool mapperTimed();
     // execute mapping, timing sceduling, visualizing, config getting
     // dumpConfig : dump configuration file
     // dumpMappedViz : dump mapped visual graph
     // resultDir: mapped result directory
-    bool execute(bool dumpConfig = true, bool dumpMappedViz = true, std::string resultDir = "");
+    // resultSuffix: suffix of the result file names, e.g. config_0.bit
+    bool execute(bool dumpConfig = true, bool dumpMappedViz = true, std::string resultDir = "", std::string resultSuffix = "");
 };
 
 
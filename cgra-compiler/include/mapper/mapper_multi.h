@@ -0,0 +1,55 @@
+#ifndef __MAPPER_MULTI_H__
+#define __MAPPER_MULTI_H__
+
+#include "mapper/mapper.h"
+#include "dfg/dfg_transform.h"
+
+
+// value carried between two ADG instances
+struct ArrayBoundary
+{
+    std::string name; // value name, same as the output name of the src sub-DFG and the input name of the dst sub-DFG
+    int srcArray; // index of the ADG instance producing the value
+    int dstArray; // index of the ADG instance consuming the value
+    int delay; // buffer delay on the link to align the value with the dst ADG instance
+};
+
+
+// System-level mapper: mapping one DFG across multiple ADG instances joined by their I/O ports
+// the DFG is partitioned into sub-DFGs (partitionDfgSpatial), each sub-DFG is mapped to one ADG instance by the array mapper,
+// then the start cycles of the ADG instances are scheduled to balance the latency across the boundaries
+class MultiArrayMapper
+{
+private:
+    Mapper* _mapper; // mapper of one ADG instance, from outside, not delete here
+    int _numArrays; // max number of the ADG instances
+    int _interLat; // latency of the link between two ADG instances
+    std::vector<int> _startCycles; // start cycle of each used ADG instance
+    std::vector<ArrayBoundary> _boundaries; // values carried between the ADG instances
+    std::map<std::string, int> _inputCycles; // <DFG-input-name, cycle feeding the first ADG instance consuming it>
+    int _latency = 0; // system latency, max cycle of the DFG outputs
+    // schedule the start cycles of the ADG instances in data-flow order (ASAP), 
+    // each one starts when its latest boundary input arrives, the earlier ones are delayed by the link buffers,
+    // then postpone the ADG instance with more output boundaries than input ones to reduce the buffer delays
+    // inLats/outLats: <I/O-name, I/O-latency> of each mapped sub-DFG
+    void schedule(DFG* dfg, const std::vector<std::map<std::string, int>>& inLats, const std::vector<std::map<std::string, int>>& outLats);
+    // dump the start cycles, boundary delays and DFG input cycles
+    void dumpSchedule(const std::string& filename);
+public:
+    MultiArrayMapper(Mapper* mapper, int numArrays, int interLat = 2) : 
+        _mapper(mapper), _numArrays(numArrays), _interLat(interLat) {}
+    ~MultiArrayMapper(){}
+    int numArrays(){ return _numArrays; }
+    int interLat(){ return _interLat; }
+    const std::vector<int>& startCycles(){ return _startCycles; }
+    const std::vector<ArrayBoundary>& boundaries(){ return _boundaries; }
+    int latency(){ return _latency; }
+    // map the DFG (without back edges) across the ADG instances, use fewer GPE nodes of each instance if some sub-DFG fails
+    // the result files of ADG instance i are suffixed with "_a<i>", the system schedule is dumped into mapped_system.txt
+    bool execute(DFG* dfg, bool dumpConfig = true, bool dumpMappedViz = true, std::string resultDir = "");
+};
+
+
+
+
+#endif
@@ -2,7 +2,28 @@
 #define __MAPPER_SA_H__
 
 #include "mapper/mapper.h"
+#include "mapper/placement.h"
 #include <cmath>
+#include <functional>
+
+
+// running statistics of the SA cost, Welford's algorithm
+struct CostStats
+{
+    int num = 0;
+    double mean = 0;
+    double m2 = 0; // sum of squares of differences from the mean
+    void add(double x){
+        num++;
+        double delta = x - mean;
+        mean += delta / num;
+        m2 += delta * (x - mean);
+    }
+    void reset(){ num = 0; mean = 0; m2 = 0; }
+    double stddev(){ return (num > 1)? std::sqrt(m2 / (num - 1)) : 0; }
+    // the spread of the cost is negligible relative to its mean
+    bool frozen(double relStd){ return stddev() <= relStd * std::abs(mean); }
+};
 
 
 // mapper using simulated annealing algorithm
@@ -14,6 +35,27 @@ private:
     // if optimize mapping objective
     bool _objOpt;
     const int MAX_TEMP = 10000; // max temperature
+    const double ACCEPT_RATE_WEIGHT = 0.1; // weight of the latest move in the accept rate
+    const int MIN_STATS_SAMPLES = 5; // min cost samples since the last improvement before checking the cost statistics
+    const double FROZEN_REL_STD = 0.001; // standard deviation of the cost relative to its mean below which the annealing is frozen
+    const int CONGEST_WEIGHT = 4; // weight of the GIB congestion in sorting candidates
+    const int ROUTE_EST_DEPTH = 8; // max GIB number of one path in the routability estimation
+    const int EXACT_MAX_TRIES = 20000; // max number of the placement tries in the exact search
+    const int EXACT_SA_TIMEOUT = 10000; // max SA time (ms) after the exact search is exhausted without proof
+    const int GREEDY_LOOKAHEAD = 8; // number of the nearest candidates evaluated by the greedy mapping
+    const int GREEDY_LAT_SLACK = 4; // max latency of the accepted greedy mapping over the critical path latency
+    // DFG node failed to be placed in the last incremental PnR, -1: none
+    int _failedDfgNodeId = -1;
+    // max range limit of the swap/shift moves, the span of the GPE array
+    int _maxRange = 0;
+    // max DFG node number to run the exact search
+    int _exactMaxNodes = 16;
+    // global placement seeding the first incremental PnR, <dfgnode-id, gpenode-id>
+    // cleared once used, empty: no seeding
+    std::map<int, int> _placeTargets;
+    // the mapping is kept after inserting the pass-through nodes, 
+    // the next PnR only places the unmapped pass-through nodes without random moves
+    bool _keepMapping = false;
 public:
     MapperSA(ADG* adg, int timeout_ms = 600000, int maxIter = 10000, bool objOpt = true);
     // MapperSA(ADG* adg, DFG* dfg);
@@ -21,11 +63,20 @@ public:
     ~MapperSA();
     void setMaxIters(int num){ _maxIters = num; }
     void setObjOpt(bool objOpt){ _objOpt = objOpt; }
+    void setExactMaxNodes(int num){ _exactMaxNodes = num; }
     // PnR and Data Synchronization
-    // return -1 : preMapCheck failed; 0 : fail; 1 : success
+    // return -1 : preMapCheck failed or only the late back edges violate; 0 : fail; 1 : success
     int pnrSync(int maxIters, int temp, bool modifyDfg = true);
     // PnR, Data Synchronization, and objective optimization
     bool pnrSyncOpt();
+    // deterministic greedy constructive mapping
+    // place the DFG nodes in topological, criticality-weighted order, then schedule the latency in a single pass
+    // return false if failed or the max latency exceeds the critical path latency by GREEDY_LAT_SLACK
+    bool greedyMap();
+    // exact backtracking mapping for small DFGs
+    // return 1 : success; 0 : proved no mapping by the routing-independent constraints;
+    // -1 : unknown, budget exhausted; -2 : unknown, the search is exhausted
+    int exactMap();
     // map the DFG to the ADG, mapper API
     virtual bool mapper();
     
@@ -34,6 +85,36 @@ protected:
     int pnr(Mapping* mapping, int temp);
     // unmap some DFG nodes
     void unmapSome(Mapping* mapping, int temp);
+    // rip up the broken part of the mapping and unmap the related DFG nodes
+    // return false if nothing is broken
+    bool ripUpSome(Mapping* mapping);
+    // if the unmapped DFG nodes can be matched to the free capable GPE nodes, bipartite matching
+    bool matchable(Mapping* mapping);
+    // forward checking: each unmapped neighbor of the DFG node keeps at least one free capable GPE node
+    // passing the routability estimation
+    bool forwardCheck(Mapping* mapping, DFGNode* dfgNode);
+    // routing-independent nogood: the DFG node cannot be placed on the GPE node under any routing state,
+    // i.e. some IO edge cannot reach the ADG IO, or some neighbor has no capable GPE node reachable from/to it
+    // nogoods: cached results, <<dfgnode-id, gpenode-id>, is-nogood>
+    bool isStaticNogood(DFGNode* dfgNode, ADGNode* gpeNode, std::map<std::pair<int, int>, bool>& nogoods);
+    // relaxed placement search only with the routing-independent constraints: capability, one DFG node per GPE node,
+    // the nogoods and the reachability between the GPE nodes of each DFG edge
+    // placement: <dfgnode-id, gpenode-id>; usedGpes: GPE nodes in the placement
+    // return 1 : placeable; 0 : exhausted, no mapping exists; -1 : budget exhausted
+    int relaxedSearch(int depth, std::map<int, int>& placement, std::set<int>& usedGpes, int& budget, 
+                      std::map<std::pair<int, int>, bool>& nogoods);
+    // backtracking search placing the DFG nodes in dfgNodeIdPlaceOrder from the depth-th one
+    // each edge is routed once by tryCandidate, the other routes are not searched
+    // return 1 : success; 0 : exhausted; -1 : budget exhausted
+    int exactSearch(Mapping* mapping, int depth, int& budget, std::map<std::pair<int, int>, bool>& nogoods);
+    // range limit of the swap/shift moves, shrinking with the temperature
+    int rangeLimit(int temp);
+    // swap/shift move: move one mapped DFG node to a GPE node within the range limit around its current location
+    // swap the two DFG nodes if the GPE node is occupied by another DFG node
+    // return false if no GPE node to move to
+    bool swapShiftMove(Mapping* mapping, int temp);
+    // calculate the global placement of the DFG nodes to seed the first incremental PnR
+    void globalPlace();
     // incremental PnR, try to map all the left DFG nodes based on current mapping status
     int incrPnR(Mapping* mapping);
     // try to map one DFG node to one of its candidates
@@ -43,10 +124,16 @@ protected:
     bool tryCandidate(Mapping* mapping, DFGNode* dfgNode, ADGNode* candidate);
     // find candidates for one DFG node based on current mapping status
     std::vector<ADGNode*> findCandidates(Mapping* mapping, DFGNode* dfgNode, int maxCandidates);
+    // find candidates in the tiles around the mapped neighbors of the DFG node, ring by ring
+    // stop when maxCandidates candidates are found
+    std::vector<ADGNode*> findCandidatesInTiles(Mapping* mapping, DFGNode* dfgNode, int maxCandidates);
     // get the shortest distance between ADG node and the available ADG input
     int getAdgNode2InputDist(Mapping* mapping, int id);
     // get the shortest distance between ADG node and the available ADG output
     int getAdgNode2OutputDist(Mapping* mapping, int id);
+    // get the congestion of the GIB nodes around the ADG node
+    // return the percentage of the used GIB output ports
+    int getAdgNodeCongestion(Mapping* mapping, ADGNode* adgNode);
     // sort candidates according to their distances with the mapped src and dst ADG nodes of this DFG node 
     // return sorted index of candidates
     std::vector<int> sortCandidates(Mapping* mapping, DFGNode* dfgNode, const std::vector<ADGNode*>& candidates);
@@ -55,8 +142,10 @@ protected:
     int objFunc(Mapping* mapping);
     // SA: the probablity of accepting new solution
     bool metropolis(double diff, double temp);
-    // annealing funtion
-    int annealFunc(int temp);
+    // target accept rate of the modified Lam schedule at the annealing progress (0~1)
+    double lamTargetRate(double progress);
+    // adaptive annealing funtion, keep the accept rate following the modified Lam schedule
+    int annealFunc(int temp, double acceptRate, double progress);
 };
 
 
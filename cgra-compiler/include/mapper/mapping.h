@@ -5,6 +5,8 @@
 #include <fstream>
 #include <algorithm>
 #include <queue>
+#include <climits>
+#include <tuple>
 #include "adg/adg.h"
 #include "dfg/dfg.h"
 
@@ -14,6 +16,7 @@ struct DFGNodeAttr
     int minLat = 0; // min latency of the input port
     int maxLat = 0; // max latency of the input port
     int lat = 0;    // latency of the output port
+    int lbLat = 0;  // latency lower bound of the output port
     // int vio = 0;
     ADGNode* adgNode = nullptr;
 };
@@ -31,7 +34,7 @@ struct EdgeLinkAttr // internal link
 struct DFGEdgeAttr
 {
     int lat = 0;
-    // int latNoDelay; // not including the delay pipe latency
+    int latNoDelay = 0; // not including the delay pipe latency
     int delay = 0; // delay pipe latency
     int vio = 0;
     std::vector<EdgeLinkAttr> edgeLinks;
@@ -70,6 +73,8 @@ struct ADGNodeAttr
 // };
 
 
+class RouteTemplates;
+
 // Mapping App. DFG to CGRA ADG
 // 1. provide basic mapping kit,
 // 2. cache mapping results
@@ -78,6 +83,8 @@ class Mapping
 private:
     ADG* _adg; // from outside, not delete here
     DFG* _dfg; // from outside, not delete here
+    RouteTemplates* _routeTemplates; // from outside, not delete here
+    int _ii; // initiation interval, the back edge with iteration distance d carries the value produced d * II cycles earlier
     int _totalViolation; // total edge latency violation
     int _maxViolation; // max edge latency violation
     int _maxLat;    // max latency of DFG
@@ -99,6 +106,29 @@ private:
 
     // DFG edges with latency violation
     std::vector<int> _vioDfgEdges;
+    // congestion map: number of the used output ports of each GIB node
+    std::map<int, int> _gibOutPortUsedCnt; // <node-id, used-port-num>
+
+    // number of the routed DFG edges with each length (link number), keep the max length after removals
+    std::map<int, int> _edgeLenCnt; // <edge-length, edge-number>
+    // total length of the routed DFG edges
+    int _totalEdgeLen = 0;
+
+    // if the latency schedule is valid for the incremental scheduling
+    bool _schedValid = false;
+    // DFG edges routed/unrouted since the last scheduling
+    std::set<int> _schedDirtyEdges;
+    // DFG nodes mapped/unmapped since the last scheduling
+    std::set<int> _schedDirtyNodes;
+    // DFG nodes in the max-latency path of the last scheduling
+    std::set<int> _critPathNodeIds;
+    // topological order index of each DFG node
+    std::map<int, int> _dfgNodeTopoIdx; // <node-id, index>
+
+    // set the output port of the ADG node as used/unused and update the GIB congestion map
+    void setAdgNodeOutPortUsed(int nodeId, int portIdx, bool used);
+    // add/remove the length of one routed DFG edge to/from the edge length statistics
+    void updateEdgeLen(int len, bool add);
 
     // route DFG edge to passthrough ADG node
     // if srcPort/dstPort == -1, auto-assign port; else assign provided port
@@ -113,15 +143,39 @@ private:
     // find a routable path from dstNode to srcNode/IB by BFS
     // srcNode = nullptr: IB
     bool routeDfgEdgeFromDst(DFGEdge* edge, ADGNode* srcNode, ADGNode* dstNode, const std::set<int>& dstPortRange);
+    // find a routable path between srcNode and dstNode by bidirectional BFS
+    // expand from both ends layer by layer and join the two halves where the frontiers meet
+    bool routeDfgEdgeFromBoth(DFGEdge* edge, ADGNode* srcNode, ADGNode* dstNode, const std::set<int>& dstPortRange);
+    // if the input port of the passthrough node is occupied by the edge with different srcId or srcPortIdx
+    bool isInPortConflict(DFGEdge* edge, int nodeId, int inPort);
+    // if the output port of the passthrough node is occupied by the edge with different srcId or srcPortIdx
+    bool isOutPortConflict(DFGEdge* edge, int nodeId, int outPort);
+    // route DFG edge along the given edge links from the src node to the dst node
+    void routeDfgEdgeLinks(DFGEdge* edge, const std::vector<EdgeLinkAttr>& edgeLinks);
+    // route DFG edge using the route templates from <srcNode, srcPort> to the available input ports of dstNode
+    // srcPort: output port of GPE or input port of IB
+    // only use the unblocked template as short as the shortest template, otherwise leave it to the search
+    bool routeDfgEdgeByTemplates(DFGEdge* edge, ADGNode* srcNode, int srcPort, ADGNode* dstNode, const std::set<int>& dstPortRange);
     // find the available input ports in the dstNode to route edge
     std::set<int> availDstPorts(DFGEdge* edge, ADGNode* dstNode); 
+    // route DFG edge from <srcNode, srcPort> to dstNode along a path whose routing latency is in [minLat, maxLat]
+    // the reged GIB output ports on the path are chained as delay registers
+    // BFS over the <node, inport-index, latency> states, the path cannot pass one node twice
+    bool routeDfgEdgeWithLat(DFGEdge* edge, ADGNode* srcNode, int srcPort, ADGNode* dstNode, int minLat, int maxLat);
+    // if the srcNode can reach one of the available input ports of the dstNode on the free tracks
+    // maxDepth: max number of the GIB nodes to be searched in one path, optimistic if exceeded
+    bool isReachable(DFGEdge* edge, ADGNode* srcNode, ADGNode* dstNode, const std::set<int>& dstPortRange, int maxDepth);
 public:
-    Mapping(ADG* adg, DFG* dfg): _adg(adg), _dfg(dfg) {}
+    Mapping(ADG* adg, DFG* dfg, RouteTemplates* routeTemplates = nullptr, int ii = 1): 
+        _adg(adg), _dfg(dfg), _routeTemplates(routeTemplates), _ii(ii) {}
     ~Mapping(){}
     // void setDFG(DFG* dfg){ _dfg = dfg; }
     DFG* getDFG(){ return _dfg; }
     // void setADG(ADG* adg){ _adg = adg; }
     ADG* getADG(){ return _adg; }
+    RouteTemplates* getRouteTemplates(){ return _routeTemplates; }
+    int ii(){ return _ii; }
+    void setII(int ii){ _ii = ii; }
     const DFGNodeAttr& dfgNodeAttr(int id){ return _dfgNodeAttr[id]; }
     const DFGEdgeAttr& dfgEdgeAttr(int id){ return _dfgEdgeAttr[id]; }
     const ADGNodeAttr& adgNodeAttr(int id){ return _adgNodeAttr[id]; }
@@ -133,6 +187,8 @@ public:
     bool isAdgNodeInPortUsed(int nodeId, int portIdx);
     // if this output port of this ADG node is used
     bool isAdgNodeOutPortUsed(int nodeId, int portIdx);
+    // number of the used output ports of the GIB node
+    int gibCongestion(int nodeId);
     // if the DFG node is already mapped
     bool isMapped(DFGNode* dfgNode);
     // if the ADG node is already mapped
@@ -161,16 +217,19 @@ public:
     // // one link can route multiple edges, but they should have the same srcId and srcPortIdx
     // bool routeDfgEdge(DFGEdge* edge, ADGLink* link);
     // route DFG edge between srcNode and dstNode
-    // find a routable path from srcNode to dstNode by BFS
+    // find a routable path between srcNode and dstNode by bidirectional BFS
     bool routeDfgEdge(DFGEdge* edge, ADGNode* srcNode, ADGNode* dstNode);
     // route DFG edge between adgNode and IOB
     // is2Input: whether connected to IB or OB 
     bool routeDfgEdge(DFGEdge* edge, ADGNode* adgNode, bool is2Input);
     // unroute DFG edge
     void unrouteDfgEdge(DFGEdge* edge);
+    // estimate if the edges between the DFG node and its mapped neighbors can be routed when mapping it to the candidate
+    // check the free operands of the dst nodes and the bounded-depth reachability on the free tracks
+    bool estRoutable(DFGNode* dfgNode, ADGNode* candidate, int maxDepth);
     // if succeed to map all DFG nodes
     bool success();
-    // total/max edge length (link number)
+    // total/max edge length (link number), maintained incrementally while routing and unrouting
     void getEdgeLen(int& totalLen, int& maxLen);
     // assign DFG IO to ADG IO according to mapping result
     // post-processing after mapping
@@ -181,22 +240,59 @@ public:
     int totalViolation(){ return _totalViolation; }
     int maxViolation(){ return _maxViolation; }
     int maxLat(){ return _maxLat; }
+    // DFG edges with latency violation
+    const std::vector<int>& vioDfgEdges(){ return _vioDfgEdges; }
     // int maxLatMis(){ return _maxLatMis; }
     // // reset the latency bounds of each DFG node
     // void resetBound();
     // calculate the routing latency of each edge, not inlcuding the delay pipe
     void calEdgeRouteLat();
+    // calculate the routing latency of one edge, not inlcuding the delay pipe
+    void calEdgeRouteLat(int eid);
+    // calculate the latency lower bound of the DFG node output port according to its src nodes
+    int calLatencyBound(DFGNode* node);
     // calculate the DFG node latency bounds not considering the Delay components 
     // including min latency of the output ports
     void latencyBound();
     // schedule the latency of each DFG node based on current mapping status
+    // only reschedule the DFG nodes affected by the changes since the last scheduling if possible
+    // if there are violations, keep the better one of the greedy schedule and the difference-constraint schedule
+    // the DFG with back edges is only scheduled by the difference constraints
     void latencySchedule();
+    // schedule the latency of all the DFG nodes
+    void latencyScheduleFull();
+    // reschedule the DFG nodes affected by the changed edges and nodes since the last scheduling
+    // return false if the max-latency path changes, need to schedule all the DFG nodes
+    bool latencyScheduleIncr();
+    // find the DFG nodes in the max-latency path according to the latency lower bounds
+    std::set<int> critPathNodes();
+    // schedule the DFG node in the max-latency path, use the latency lower bound as the target latency
+    // return true if the latency of this DFG node changed
+    bool scheduleCritDfgNode(DFGNode* dfgNode);
+    // schedule the DFG node not in the max-latency path according to its scheduled dst nodes
+    // return true if the latency of this DFG node changed
+    bool scheduleDfgNode(DFGNode* dfgNode);
+    // schedule the latency by solving the difference constraints of the DFG edges
+    // drop the max delay constraints in the infeasible cycles as the latency violations,
+    // all of them if too many infeasible cycles
+    // back edge (u, v) with iteration distance d: lat(u) - d * II is used as the src latency
+    void latencyScheduleDC();
     // calculate the latency of DFG IO
     void calIOLat();
     // calculate the latency violation of each edge
     void calEdgeLatVio();
+    // calculate the latency and violation of the edge connected to DFG node, return the violation
+    int calEdgeLatVio(int eid);
+    // reroute the GPE-to-GPE edges with latency violations through detours with more reged GIB output ports
+    // the detour latency absorbs the violation beyond the max delay of the delay pipe
+    // return the number of the padded edges, need to schedule the latency again
+    int padLatency();
     // insert pass-through DFG nodes into a copy of current DFG
-    void insertPassDfgNodes(DFG* newDfg);
+    // return the number of the split edges
+    int insertPassDfgNodes(DFG* newDfg);
+    // rebind the mapping to the new DFG generated by insertPassDfgNodes, call before the current DFG is deleted
+    // keep the placement and routes of the unchanged DFG nodes and edges, unroute the split edges
+    void rebindDfg(DFG* newDfg);
 };
 
 
@@ -0,0 +1,80 @@
+#ifndef __PLACEMENT_H__
+#define __PLACEMENT_H__
+
+#include <map>
+#include <set>
+#include <vector>
+#include <cmath>
+#include "adg/adg.h"
+#include "dfg/dfg.h"
+
+
+// clustered DFG graph of one level in the multilevel placement
+struct PlaceGraph
+{
+    std::map<int, int> size; // <cluster-id, DFG node number>
+    std::map<int, std::map<int, int>> adj; // <cluster-id, <cluster-id, edge number>>, undirected
+    std::map<int, int> numIn; // <cluster-id, number of the edges from the DFG input>
+    std::map<int, int> numOut; // <cluster-id, number of the edges to the DFG output>
+    std::map<int, double> level; // <cluster-id, average topological level>
+};
+
+
+// GPE tile used in the two-level legalization
+struct PlaceTile
+{
+    std::vector<int> gpeIds; // GPE node IDs in this tile
+    double minX, maxX, minY, maxY; // bounding box of the GPE nodes
+};
+
+
+// Global placer: multilevel force-directed wirelength minimization over the GPE grid
+// the DFG is coarsened by merging the tightly connected nodes, the coarsest graph is placed onto
+// groups of nearby GPE nodes, then uncoarsened with local refinement at each level
+// each refinement iteration moves the nodes to the weighted center of their neighbors, IO anchors and
+// the last legal locations, then legalizes the result
+// the finest level is legalized in two levels: first to the nearest tile with free capable GPE nodes, then inside the tile
+class GlobalPlacer
+{
+private:
+    ADG* _adg; // from outside, not delete here
+    int _maxIters; // max iteration number of each level
+    const int COARSEST_SIZE = 16; // stop coarsening when the cluster number is no more than COARSEST_SIZE
+    const int MAX_CLUSTER_SIZE = 8; // max DFG node number of one cluster
+    // GPE node IDs
+    std::vector<int> _gpeIds;
+    // GPE tiles
+    std::vector<PlaceTile> _tiles;
+    // IB/OB node IDs
+    std::vector<int> _ibIds, _obIds;
+    // nearest IB/OB location to (x, y)
+    std::pair<double, double> nearestIO(const std::vector<int>& ioIds, double x, double y);
+    // build the finest graph from the DFG
+    PlaceGraph buildGraph(DFG* dfg);
+    // coarsen the graph by heavy-edge matching
+    // return the coarse graph, parent: <cluster-id, coarse-cluster-id>
+    PlaceGraph coarsen(const PlaceGraph& graph, std::map<int, int>& parent);
+    // move the clusters to the weighted center of their neighbors, IO anchors and the legal locations
+    std::map<int, std::pair<double, double>> relax(const PlaceGraph& graph, const std::map<int, std::pair<double, double>>& pos, 
+                                                   const std::map<int, std::pair<double, double>>& legalPos, double anchorWeight);
+    // legalize the clusters onto groups of nearby GPE nodes, ignoring the operation capability
+    // return the center of each group
+    std::map<int, std::pair<double, double>> legalizeGroups(const PlaceGraph& graph, const std::map<int, std::pair<double, double>>& pos);
+    // legalize the DFG node locations onto the capable and free GPE nodes in the given order
+    // return <dfgnode-id, gpenode-id>, empty if failed
+    std::map<int, int> legalize(DFG* dfg, const std::vector<int>& order, const std::map<int, std::pair<double, double>>& pos);
+    // total manhattan wirelength of the legal placement
+    int wirelength(DFG* dfg, const std::map<int, int>& placement);
+public:
+    // tiles: <<tile-col, tile-row>, GPE node IDs>
+    GlobalPlacer(ADG* adg, const std::map<std::pair<int, int>, std::vector<int>>& tiles, int maxIters = 20);
+    ~GlobalPlacer(){}
+    // place the DFG nodes, the DFG node IDs in order are legalized first
+    // return the best legal placement, <dfgnode-id, gpenode-id>, empty if failed
+    std::map<int, int> place(DFG* dfg, const std::vector<int>& order);
+};
+
+
+
+
+#endif
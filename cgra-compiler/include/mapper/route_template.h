@@ -0,0 +1,50 @@
+#ifndef __ROUTE_TEMPLATE_H__
+#define __ROUTE_TEMPLATE_H__
+
+#include "mapper/mapping.h"
+
+
+// Route template library of one ADG
+// precompute several diverse shortest paths through the GIB network for each pair of endpoints:
+// GPE output port -> GPE input port, IB input port -> GPE input port
+// the paths are stored as shortest path trees of each src port, calculated on the first query of the src port
+class RouteTemplates
+{
+private:
+    // link of the shortest path tree
+    struct TreeLink{
+        int parent; // index of the former link in the tree, -1: the src node
+        int srcPort; // source port of the passed node
+        int dstPort; // destination port of the passed node
+        ADGNode* adgNode; // pass-through node or src node
+    };
+    // shortest path tree of one round
+    struct RouteTree{
+        std::vector<TreeLink> links; // only the links on the paths to the dst nodes
+        std::map<std::pair<int, int>, int> dsts; // <<dst-node-id, dst-inport-idx>, index of the last link to the dst node>
+    };
+    ADG* _adg; // from outside, not delete here
+    int _maxTemplates; // max template number of each pair of endpoints
+    int _maxCost; // max cost of the cached paths
+    // shortest path trees of the rounds, <<src-node-id, src-port-idx>, vector<tree>>
+    // src-port-idx: output port index of GPE, input port index of IB
+    std::map<std::pair<int, int>, std::vector<RouteTree>> _trees;
+    // calculate the shortest path trees starting from the src port of the src node
+    // each round finds the shortest path tree penalizing the GIB nodes used in the former rounds
+    void calTemplates(ADGNode* srcNode, int srcPort);
+public:
+    RouteTemplates(ADG* adg, int maxTemplates = 3, int maxCost = INT_MAX) : 
+        _adg(adg), _maxTemplates(maxTemplates), _maxCost(maxCost) {}
+    ~RouteTemplates(){}
+    int maxTemplates(){ return _maxTemplates; }
+    // number of the cached paths
+    int numTemplates();
+    // route templates between <src-node-id, src-port-idx> and <dst-node-id, dst-inport-idx>
+    // path: edge links from the src node to the dst node, same format as DFGEdgeAttr::edgeLinks
+    std::vector<std::vector<EdgeLinkAttr>> templates(int srcId, int srcPort, int dstId, int dstPort);
+};
+
+
+
+
+#endif
@@ -9,12 +9,13 @@ class Graphviz
 private:
     Mapping* _mapping; // from outside, not delete here
     std::string _dirname; // file directory name 
+    std::string _suffix; // file name suffix, e.g. "_0" for the first sub-DFG
     // create name for DFG node
     std::string getDfgNodeName(int id, int idx = 0, bool isDfgInput = true);
     // create name for ADG node
     std::string getAdgNodeName(int id, int idx = 0, bool isDfgInput = true);
 public:
-    Graphviz(Mapping* mapping, std::string dirname);
+    Graphviz(Mapping* mapping, std::string dirname, std::string suffix = "");
     ~Graphviz(){}  
     // draw scheduled DFG with latency annotated
     void drawDFG();    
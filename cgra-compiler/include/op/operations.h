@@ -19,6 +19,7 @@ struct OpInfo
     float area;
     float power;
     bool commutative;
+    bool associative;
 };
 
 // singleton class
@@ -47,6 +48,8 @@ public:
     static float power(const std::string& op);
     // if operands are commutative
     static bool isCommutative(const std::string& op);
+    // if the operation is associative
+    static bool isAssociative(const std::string& op);
     // if the operation is supported
     static bool opCapable(const std::string& op);
 };
@@ -177,10 +177,12 @@ void DFG::addEdge(DFGEdge* edge){
 
 void DFG::delNode(int id){
     DFGNode* dfgNode = node(id);
-    for(auto& elem : dfgNode->inputEdges()){
+    auto inEdges = dfgNode->inputEdges(); // copy, delEdge modifies the edge maps of the node
+    for(auto& elem : inEdges){
         delEdge(elem.second);
     }
-    for(auto& elem : dfgNode->outputEdges()){
+    auto outEdges = dfgNode->outputEdges();
+    for(auto& elem : outEdges){
         for(auto eid : elem.second){
             delEdge(eid);
         }        
@@ -230,6 +232,9 @@ void DFG::dfs(DFGNode* node, std::map<int, bool>& visited){
         if(inNodeId == _id){ // node connected to DFG input port
             continue;
         }
+        if(_edges[node->inputEdge(in.first)]->isBackEdge()){ // loop-carried dependence
+            continue;
+        }
         dfs(_nodes[inNodeId], visited); // visit input node
     }
     _topoNodes.push_back(_nodes[nodeId]);
@@ -246,6 +251,29 @@ void DFG::topoSortNodes(){
         }
         dfs(_nodes[outNodeId], visited); // visit output node
     }
+    // the source node of a back edge is visited after the destination node
+    bool added = true;
+    while(added){
+        added = false;
+        for(auto& elem : _edges){
+            DFGEdge* edge = elem.second;
+            if(edge->isBackEdge() && visited.count(edge->dstId()) && !visited.count(edge->srcId())){
+                dfs(_nodes[edge->srcId()], visited);
+                added = true;
+            }
+        }
+    }
+}
+
+
+// if there are back edges (loop-carried dependences)
+bool DFG::hasBackEdge(){
+    for(auto& elem : _edges){
+        if(elem.second->isBackEdge()){
+            return true;
+        }
+    }
+    return false;
 }
 
 
@@ -0,0 +1,1059 @@
+
+#include "dfg/dfg_transform.h"
+#include <queue>
+#include <algorithm>
+#include <functional>
+#include "spdlog/spdlog.h"
+
+
+// if the node can be a member of the operation chain
+static bool isChainOp(DFGNode* node){
+    std::string op = node->operation();
+    return Operations::isCommutative(op) && Operations::isAssociative(op) &&
+           !node->hasImm() && node->inputs().size() == 2;
+}
+
+
+// if the node can be merged into its consumer chain, i.e. not the root of the chain
+static bool isChainInner(DFG* dfg, DFGNode* node){
+    if(!isChainOp(node)){
+        return false;
+    }
+    int numOutEdges = 0;
+    int dstId = -1;
+    bool backEdge = false;
+    for(auto& elem : node->outputEdges()){
+        numOutEdges += elem.second.size();
+        for(int eid : elem.second){
+            dstId = dfg->edge(eid)->dstId();
+            backEdge = dfg->edge(eid)->isBackEdge();
+        }
+    }
+    // multiple consumers, connected to DFG output port or consumed in the next iterations
+    if(numOutEdges != 1 || dstId == dfg->id() || backEdge){
+        return false;
+    }
+    DFGNode* dst = dfg->node(dstId);
+    return isChainOp(dst) && dst->operation() == node->operation() && dst->bitWidth() == node->bitWidth();
+}
+
+
+// collect the inner nodes and the operands (leaves) of the chain rooted at the node
+// leaves: <src-node-id, src-port-idx>
+static void collectChain(DFG* dfg, DFGNode* node, std::vector<int>& inners, std::vector<std::pair<int, int>>& leaves){
+    for(auto& elem : node->inputs()){
+        auto src = elem.second;
+        if(src.first != dfg->id() && isChainInner(dfg, dfg->node(src.first))){
+            inners.push_back(src.first);
+            collectChain(dfg, dfg->node(src.first), inners, leaves);
+        } else{
+            leaves.push_back(src);
+        }
+    }
+}
+
+
+// arrival time of the node output, assuming ASAP schedule without routing latency
+static int arrivalTime(DFG* dfg, int nodeId, std::map<int, int>& arrival){
+    if(nodeId == dfg->id()){ // DFG input port
+        return 0;
+    }
+    if(arrival.count(nodeId)){
+        return arrival[nodeId];
+    }
+    DFGNode* node = dfg->node(nodeId);
+    int lat = 0;
+    for(auto& elem : node->inputs()){
+        if(dfg->edge(node->inputEdge(elem.first))->isBackEdge()){ // value of the former iteration
+            continue;
+        }
+        lat = std::max(lat, arrivalTime(dfg, elem.second.first, arrival));
+    }
+    lat += node->opLatency();
+    arrival[nodeId] = lat;
+    return lat;
+}
+
+
+// Tree-height reduction
+// rebalance the chains of commutative and associative operations (e.g. ADD, MUL) into balanced trees
+// chain: the nodes with the same operation and bit-width, each non-root node has only one consumer in the chain
+// the operands of the chain are combined in the order of their arrival time (ASAP),
+// the node IDs of the chain are reused and the root node keeps its ID and outputs
+// return true if the DFG is modified
+bool reduceTreeHeight(DFG* dfg){
+    bool modified = false;
+    dfg->topoSortNodes();
+    std::vector<DFGNode*> topoNodes = dfg->topoNodes(); // copy, the inner nodes are rewired below
+    std::map<int, int> arrival; // <node-id, arrival-time>
+    // the leaves of one chain are upstream of its root, so handling the roots in topological order
+    // makes the arrival time of the leaves reflect the former rebalanced chains
+    for(DFGNode* root : topoNodes){
+        if(!isChainOp(root) || isChainInner(dfg, root)){
+            continue;
+        }
+        std::vector<int> inners;
+        std::vector<std::pair<int, int>> leaves;
+        collectChain(dfg, root, inners, leaves);
+        if(inners.empty()){ // two operands, already balanced
+            continue;
+        }
+        // keep the chain with loop-carried operands, the rebuilt edges cannot keep the iteration distance
+        bool loopCarried = false;
+        for(int nodeId : inners){
+            for(auto& elem : dfg->node(nodeId)->inputEdges()){
+                loopCarried |= dfg->edge(elem.second)->isBackEdge();
+            }
+        }
+        for(auto& elem : root->inputEdges()){
+            loopCarried |= dfg->edge(elem.second)->isBackEdge();
+        }
+        if(loopCarried){
+            continue;
+        }
+        int oldLat = arrivalTime(dfg, root->id(), arrival);
+        int opLat = root->opLatency();
+        // <arrival-time, <src-node-id, src-port-idx>>, earliest first
+        typedef std::pair<int, std::pair<int, int>> QueElem;
+        std::priority_queue<QueElem, std::vector<QueElem>, std::greater<QueElem>> leafQue;
+        for(auto& leaf : leaves){
+            leafQue.push(std::make_pair(arrivalTime(dfg, leaf.first, arrival), leaf));
+        }
+        // combine the two earliest operands each time (Huffman-style), estimate the new root arrival time
+        auto estQue = leafQue;
+        while(estQue.size() > 1){
+            int t1 = estQue.top().first;
+            estQue.pop();
+            int t2 = estQue.top().first;
+            estQue.pop();
+            estQue.push(std::make_pair(std::max(t1, t2) + opLat, std::make_pair(-1, -1)));
+        }
+        int newLat = estQue.top().first;
+        if(newLat >= oldLat){
+            continue;
+        }
+        // delete the input edges of the chain nodes, reuse their IDs
+        std::vector<int> chainNodes = inners;
+        chainNodes.push_back(root->id()); // the root combines the last two operands
+        std::vector<int> edgeIds;
+        for(int nodeId : chainNodes){
+            for(auto& elem : dfg->node(nodeId)->inputEdges()){
+                edgeIds.push_back(elem.second);
+            }
+        }
+        for(int eid : edgeIds){
+            dfg->delEdge(eid);
+        }
+        std::sort(edgeIds.begin(), edgeIds.end());
+        int nodeIdx = 0;
+        int edgeIdx = 0;
+        while(leafQue.size() > 1){
+            int nodeId = chainNodes[nodeIdx++];
+            int t = 0;
+            for(int i = 0; i < 2; i++){
+                auto src = leafQue.top().second;
+                t = std::max(t, leafQue.top().first);
+                leafQue.pop();
+                DFGEdge* e = new DFGEdge(src.first, nodeId);
+                e->setId(edgeIds[edgeIdx++]);
+                e->setSrcPortIdx(src.second);
+                e->setDstPortIdx(i);
+                dfg->addEdge(e);
+            }
+            arrival[nodeId] = t + opLat;
+            leafQue.push(std::make_pair(t + opLat, std::make_pair(nodeId, 0))); // single-result operation
+        }
+        assert(nodeIdx == chainNodes.size() && edgeIdx == edgeIds.size());
+        modified = true;
+    }
+    if(modified){
+        dfg->topoSortNodes();
+    }
+    return modified;
+}
+
+
+// mask of the data with bitWidth bits
+static uint64_t dataMask(int bitWidth){
+    return (bitWidth <= 0 || bitWidth >= 64)? ~(uint64_t)0 : (((uint64_t)1 << bitWidth) - 1);
+}
+
+
+// evaluate the operation with constant operands, same as the ALU functions of the ADG
+// return false if the operation cannot be evaluated
+static bool evalOp(const std::string& op, const std::vector<uint64_t>& operands, int bitWidth, uint64_t& res){
+    uint64_t mask = dataMask(bitWidth);
+    int shnBits = 0; // bits of the shift number, log2Ceil(bitWidth)
+    while((1 << shnBits) < bitWidth) shnBits++;
+    uint64_t a = operands.size() > 0? (operands[0] & mask) : 0;
+    uint64_t b = operands.size() > 1? (operands[1] & mask) : 0;
+    uint64_t shn = b & (((uint64_t)1 << shnBits) - 1);
+    if(op == "PASS"){
+        res = a;
+    } else if(op == "ADD"){
+        res = a + b;
+    } else if(op == "SUB"){
+        res = a - b;
+    } else if(op == "MUL"){
+        res = a * b;
+    } else if(op == "AND"){
+        res = a & b;
+    } else if(op == "OR"){
+        res = a | b;
+    } else if(op == "XOR"){
+        res = a ^ b;
+    } else if(op == "SHL"){
+        res = a << shn;
+    } else if(op == "LSHR"){
+        res = a >> shn;
+    } else if(op == "ASHR"){
+        int64_t sa = (int64_t)a;
+        if(bitWidth > 0 && bitWidth < 64){ // sign extension
+            sa = (int64_t)(a << (64 - bitWidth)) >> (64 - bitWidth);
+        }
+        res = (uint64_t)(sa >> shn);
+    } else if(op == "EQ"){
+        res = a == b;
+    } else if(op == "NE"){
+        res = a != b;
+    } else if(op == "LT"){
+        res = a < b;
+    } else if(op == "LE"){
+        res = a <= b;
+    } else if(op == "SEL"){
+        res = (operands[2] & 1)? b : a;
+    } else{
+        return false;
+    }
+    res &= mask;
+    return true;
+}
+
+
+// if the node is a constant node, i.e. no input edge and one immediate operand
+static bool isConstNode(DFGNode* node){
+    return node->inputs().empty() && node->hasImm() && Operations::numOperands(node->operation()) == 1;
+}
+
+
+// set the node as a constant node with the value
+static void setConstNode(DFG* dfg, DFGNode* node, uint64_t value){
+    auto inEdges = node->inputEdges(); // copy
+    for(auto& elem : inEdges){
+        dfg->delEdge(elem.second);
+    }
+    node->setOperation("PASS");
+    node->setImm(value);
+    node->setImmIdx(0);
+}
+
+
+// connect the consumers of the output port of the node to the new source <node-id, port-idx>
+// reuse the IDs of the redirected edges, iterDist: iteration distance added to the redirected edges
+static void replaceUses(DFG* dfg, DFGNode* node, int outPort, int newSrcId, int newSrcPort, int iterDist = 0){
+    auto outEdges = node->outputEdge(outPort); // copy
+    for(int eid : outEdges){
+        DFGEdge* e = dfg->edge(eid);
+        int dstId = e->dstId();
+        int dstPort = e->dstPortIdx();
+        int newIterDist = e->iterDist() + iterDist;
+        dfg->delEdge(eid);
+        DFGEdge* newEdge = new DFGEdge(newSrcId, dstId);
+        newEdge->setId(eid);
+        newEdge->setSrcPortIdx(newSrcPort);
+        newEdge->setDstPortIdx(dstPort);
+        newEdge->setIterDist(newIterDist);
+        dfg->addEdge(newEdge);
+    }
+}
+
+
+// if any consumer of the node is DFG output port
+static bool drivesDfgOutput(DFG* dfg, DFGNode* node){
+    for(auto& elem : node->outputEdges()){
+        for(int eid : elem.second){
+            if(dfg->edge(eid)->dstId() == dfg->id()){
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+
+// IDs of the DFG nodes in topological order
+static std::vector<int> topoNodeIds(DFG* dfg){
+    dfg->topoSortNodes();
+    std::vector<int> ids;
+    for(DFGNode* node : dfg->topoNodes()){
+        ids.push_back(node->id());
+    }
+    return ids;
+}
+
+
+// Constant propagation and folding
+// constant node: no input edge, one immediate operand, e.g. PASS(imm)
+// absorb the constant node into the consumers without immediate operand,
+// fold the node whose operands are all constant into a constant node
+// return true if the DFG is modified
+bool foldConstants(DFG* dfg, int bitWidth){
+    bool modified = false;
+    for(int id : topoNodeIds(dfg)){
+        DFGNode* node = dfg->node(id);
+        std::string op = node->operation();
+        if(isConstNode(node)){
+            uint64_t value;
+            if(!evalOp(op, {node->imm()}, bitWidth, value)){
+                continue;
+            }
+            auto outEdges = node->outputEdges(); // copy
+            for(auto& elem : outEdges){
+                for(int eid : elem.second){
+                    DFGEdge* e = dfg->edge(eid);
+                    int dstId = e->dstId();
+                    int dstPort = e->dstPortIdx();
+                    // cannot absorb; the loop-carried constant is not valid in the first iterations
+                    if(dstId == dfg->id() || dfg->node(dstId)->hasImm() || e->isBackEdge()){
+                        continue;
+                    }
+                    dfg->delEdge(eid);
+                    DFGNode* dst = dfg->node(dstId);
+                    dst->setImm(value);
+                    dst->setImmIdx(dstPort);
+                    modified = true;
+                }
+            }
+            continue;
+        }
+        int numOperands = Operations::numOperands(op);
+        if(!node->hasImm() || node->inputs().empty() || numOperands != node->numInputs()){
+            continue;
+        }
+        std::vector<uint64_t> operands(numOperands, 0);
+        operands[node->immIdx()] = node->imm();
+        bool allConst = true;
+        for(auto& elem : node->inputs()){
+            int srcId = elem.second.first;
+            uint64_t value;
+            if(srcId == dfg->id() || !isConstNode(dfg->node(srcId)) ||
+               dfg->edge(node->inputEdge(elem.first))->isBackEdge() ||
+               !evalOp(dfg->node(srcId)->operation(), {dfg->node(srcId)->imm()}, bitWidth, value)){
+                allConst = false;
+                break;
+            }
+            operands[elem.first] = value;
+        }
+        uint64_t res;
+        if(allConst && evalOp(op, operands, bitWidth, res)){
+            setConstNode(dfg, node, res);
+            modified = true;
+        }
+    }
+    return modified;
+}
+
+
+// Algebraic simplification of the nodes with immediate operand
+// x+0, x-0, x*1, x|0, x^0, x&-1, x<<0, x>>0 => x; x*0, x&0 => 0;
+// x*2^k => x<<k if shlPreferred
+// return true if the DFG is modified
+bool simplifyAlgebra(DFG* dfg, int bitWidth, bool shlPreferred){
+    bool modified = false;
+    uint64_t mask = dataMask(bitWidth);
+    int shnBits = 0; // bits of the shift number
+    while((1 << shnBits) < bitWidth) shnBits++;
+    for(int id : topoNodeIds(dfg)){
+        DFGNode* node = dfg->node(id);
+        std::string op = node->operation();
+        if(!node->hasImm() || node->inputs().size() != 1 || Operations::numOperands(op) != 2){
+            continue;
+        }
+        uint64_t c = node->imm() & mask;
+        int immIdx = node->immIdx();
+        auto x = node->inputs().begin()->second; // the other operand, <src-node-id, src-port-idx>
+        int xPort = node->inputs().begin()->first;
+        int xIterDist = dfg->edge(node->inputEdge(xPort))->iterDist();
+        bool identity = false;
+        bool zero = false;
+        if(op == "ADD" || op == "OR" || op == "XOR"){
+            identity = (c == 0);
+        } else if(op == "SUB"){
+            identity = (c == 0 && immIdx == 1);
+        } else if(op == "MUL"){
+            identity = (c == 1);
+            zero = (c == 0);
+        } else if(op == "AND"){
+            identity = (c == mask);
+            zero = (c == 0);
+        } else if(op == "SHL" || op == "LSHR" || op == "ASHR"){
+            identity = ((c & (((uint64_t)1 << shnBits) - 1)) == 0 && immIdx == 1);
+        }
+        if(identity){
+            // keep the node if it is the only one between the DFG input and output ports
+            if(x.first == dfg->id() && drivesDfgOutput(dfg, node)){
+                continue;
+            }
+            auto outputs = node->outputs(); // copy
+            for(auto& elem : outputs){
+                replaceUses(dfg, node, elem.first, x.first, x.second, xIterDist);
+            }
+            modified = true;
+        } else if(zero){
+            setConstNode(dfg, node, 0);
+            modified = true;
+        } else if(op == "MUL" && shlPreferred && c > 1 && (c & (c - 1)) == 0){
+            int k = 0;
+            while(((uint64_t)1 << k) != c) k++;
+            node->setOperation("SHL");
+            node->setImm(k);
+            node->setImmIdx(1);
+            if(xPort != 0){ // shifted operand must be the first one
+                int eid = node->inputEdge(xPort);
+                dfg->delEdge(eid);
+                DFGEdge* e = new DFGEdge(x.first, id);
+                e->setId(eid);
+                e->setSrcPortIdx(x.second);
+                e->setDstPortIdx(0);
+                e->setIterDist(xIterDist);
+                dfg->addEdge(e);
+            }
+            modified = true;
+        }
+    }
+    return modified;
+}
+
+
+// Common-subexpression elimination
+// merge the nodes with the same operation, immediate operand and inputs
+// return true if the DFG is modified
+bool eliminateCommonSubexpr(DFG* dfg){
+    bool modified = false;
+    // <key, node-id>, key: OPC, bit-width, immediate operand, inputs
+    std::map<std::vector<uint64_t>, int> exprs;
+    for(int id : topoNodeIds(dfg)){
+        DFGNode* node = dfg->node(id);
+        bool commutative = node->commutative();
+        std::vector<uint64_t> key = {(uint64_t)Operations::OPC(node->operation()), (uint64_t)node->bitWidth()};
+        if(node->hasImm()){
+            key.push_back(1);
+            key.push_back(node->imm());
+            key.push_back(commutative? 0 : node->immIdx());
+        } else{
+            key.push_back(0);
+        }
+        std::vector<std::vector<uint64_t>> ins; // <input-index, src-node-id, src-port-idx, iteration-distance>
+        for(auto& elem : node->inputs()){
+            uint64_t idx = commutative? 0 : elem.first; // operand order does not matter if commutative
+            uint64_t iterDist = dfg->edge(node->inputEdge(elem.first))->iterDist();
+            ins.push_back({idx, (uint64_t)elem.second.first, (uint64_t)elem.second.second, iterDist});
+        }
+        std::sort(ins.begin(), ins.end());
+        for(auto& in : ins){
+            key.insert(key.end(), in.begin(), in.end());
+        }
+        if(!exprs.count(key)){
+            exprs[key] = id;
+            continue;
+        }
+        // the same expression is upstream in topological order
+        auto outputs = node->outputs(); // copy
+        for(auto& elem : outputs){
+            replaceUses(dfg, node, elem.first, exprs[key], elem.first);
+        }
+        dfg->delNode(id);
+        modified = true;
+    }
+    return modified;
+}
+
+
+// Dead-node elimination
+// delete the nodes that cannot reach any DFG output port
+// return true if the DFG is modified
+bool eliminateDeadNodes(DFG* dfg){
+    dfg->topoSortNodes(); // only the nodes reaching the DFG output ports are sorted
+    std::set<int> liveNodes;
+    for(DFGNode* node : dfg->topoNodes()){
+        liveNodes.emplace(node->id());
+    }
+    std::vector<int> deadNodes;
+    for(auto& elem : dfg->nodes()){
+        if(!liveNodes.count(elem.first)){
+            deadNodes.push_back(elem.first);
+        }
+    }
+    for(int id : deadNodes){
+        dfg->delNode(id);
+    }
+    return !deadNodes.empty();
+}
+
+
+// copy the attributes of the DFG node without the connections
+static DFGNode* copyDfgNode(DFGNode* node){
+    DFGNode* newNode = new DFGNode();
+    newNode->setId(node->id());
+    newNode->setName(node->name());
+    newNode->setType(node->type());
+    newNode->setOperation(node->operation());
+    newNode->setBitWidth(node->bitWidth());
+    if(node->hasImm()){
+        newNode->setImm(node->imm());
+        newNode->setImmIdx(node->immIdx());
+    }
+    if(node->hasRegion()){
+        newNode->setRegion(node->region());
+    }
+    return newNode;
+}
+
+
+// append the nodes, edges and I/O ports of the DFG to the new DFG,
+// offsetting the node IDs, edge IDs, input and output indexes, suffixing the names
+static void appendDfg(DFG* newDfg, DFG* dfg, int nodeOffset, int edgeOffset, int inputOffset, int outputOffset, const std::string& suffix){
+    for(auto& elem : dfg->inputs()){
+        newDfg->setInputName(elem.first + inputOffset, dfg->inputName(elem.first) + suffix);
+    }
+    for(auto& elem : dfg->outputs()){
+        newDfg->setOutputName(elem.first + outputOffset, dfg->outputName(elem.first) + suffix);
+    }
+    for(auto& elem : dfg->nodes()){
+        DFGNode* newNode = copyDfgNode(elem.second);
+        newNode->setId(elem.first + nodeOffset);
+        newNode->setName(elem.second->name() + suffix);
+        newDfg->addNode(newNode);
+    }
+    for(auto& elem : dfg->edges()){
+        DFGEdge* e = elem.second;
+        int srcId = e->srcId();
+        int dstId = e->dstId();
+        int srcPort = e->srcPortIdx();
+        int dstPort = e->dstPortIdx();
+        if(srcId == dfg->id()){ // DFG input port
+            srcId = newDfg->id();
+            srcPort += inputOffset;
+        } else{
+            srcId += nodeOffset;
+        }
+        if(dstId == dfg->id()){ // DFG output port
+            dstId = newDfg->id();
+            dstPort += outputOffset;
+        } else{
+            dstId += nodeOffset;
+        }
+        DFGEdge* newEdge = new DFGEdge(srcId, dstId);
+        newEdge->setId(e->id() + edgeOffset);
+        newEdge->setSrcPortIdx(srcPort);
+        newEdge->setDstPortIdx(dstPort);
+        newEdge->setIterDist(e->iterDist());
+        newDfg->addEdge(newEdge);
+    }
+}
+
+
+// DFG replication
+// copy the DFG several times into one DFG, each copy has its own nodes, edges and I/O ports
+// copy i: node ID + i * max-node-ID, edge ID + i * (max-edge-ID + 1), I/O index + i * (max-I/O-index + 1),
+// the names in copy i (i > 0) are suffixed with "_r<i>"
+// return the new DFG, deleted outside
+DFG* replicateDfg(DFG* dfg, int copies){
+    int maxNodeId = dfg->nodes().empty()? 0 : dfg->nodes().rbegin()->first;
+    int maxEdgeId = dfg->edges().empty()? 0 : dfg->edges().rbegin()->first;
+    int numInputIdx = dfg->inputs().empty()? 0 : dfg->inputs().rbegin()->first + 1;
+    int numOutputIdx = dfg->outputs().empty()? 0 : dfg->outputs().rbegin()->first + 1;
+    DFG* newDfg = new DFG();
+    newDfg->setId(dfg->id());
+    newDfg->setBitWidth(dfg->bitWidth());
+    for(int i = 0; i < copies; i++){
+        std::string suffix = (i == 0)? "" : "_r" + std::to_string(i);
+        appendDfg(newDfg, dfg, i * maxNodeId, i * (maxEdgeId + 1), i * numInputIdx, i * numOutputIdx, suffix);
+    }
+    newDfg->topoSortNodes();
+    return newDfg;
+}
+
+
+// DFG merging
+// merge the independent DFGs into one DFG, each DFG keeps its own nodes, edges and I/O ports
+// the node IDs, edge IDs and I/O indexes of DFG k follow the ones of DFG k-1,
+// the names in DFG k (k > 0) are suffixed with "_m<k>"
+// return the new DFG, deleted outside
+DFG* mergeDfgs(const std::vector<DFG*>& dfgs){
+    DFG* newDfg = new DFG();
+    newDfg->setId(dfgs.empty()? 0 : dfgs[0]->id());
+    newDfg->setBitWidth(dfgs.empty()? 0 : dfgs[0]->bitWidth());
+    int nodeOffset = 0;
+    int edgeOffset = 0;
+    int inputOffset = 0;
+    int outputOffset = 0;
+    for(int k = 0; k < dfgs.size(); k++){
+        DFG* dfg = dfgs[k];
+        std::string suffix = (k == 0)? "" : "_m" + std::to_string(k);
+        appendDfg(newDfg, dfg, nodeOffset, edgeOffset, inputOffset, outputOffset, suffix);
+        nodeOffset += dfg->nodes().empty()? 0 : dfg->nodes().rbegin()->first;
+        edgeOffset += dfg->edges().empty()? 0 : dfg->edges().rbegin()->first + 1;
+        inputOffset += dfg->inputs().empty()? 0 : dfg->inputs().rbegin()->first + 1;
+        outputOffset += dfg->outputs().empty()? 0 : dfg->outputs().rbegin()->first + 1;
+    }
+    newDfg->topoSortNodes();
+    return newDfg;
+}
+
+
+// name of the value <node-id, port-idx> carried between the sub-DFGs
+// use the name of the DFG output port if the value drives one
+static std::string cutValueName(DFG* dfg, int nodeId, int port){
+    DFGNode* node = dfg->node(nodeId);
+    for(int eid : node->outputEdge(port)){
+        DFGEdge* e = dfg->edge(eid);
+        if(e->dstId() == dfg->id()){
+            return dfg->outputName(e->dstPortIdx());
+        }
+    }
+    return node->name() + ((port == 0)? "" : "_" + std::to_string(port));
+}
+
+
+// I/O port number of the sub-DFG with the nodes in the part, <input-number, output-number>
+// the src nodes outside the part are in the former sub-DFGs, the dst nodes outside the part in the latter ones
+// liveNodes: the nodes reaching the DFG output ports
+// first: the first sub-DFG also carries the DFG input-output passthrough
+static std::pair<int, int> partIONum(DFG* dfg, const std::set<int>& part, const std::map<int, int>& liveNodes, bool first){
+    std::set<std::pair<int, int>> ins; // <src-node-id (DFG ID for DFG input port), src-port-idx>
+    int numOut = 0;
+    for(int id : part){
+        DFGNode* node = dfg->node(id);
+        for(auto& elem : node->inputEdges()){
+            DFGEdge* e = dfg->edge(elem.second);
+            if(!part.count(e->srcId())){
+                ins.emplace(e->srcId(), e->srcPortIdx());
+            }
+        }
+        for(auto& elem : node->outputEdges()){
+            bool drivesOut = false; // drive DFG output port
+            bool cut = false; // consumed by the latter sub-DFGs
+            for(int eid : elem.second){
+                int dstId = dfg->edge(eid)->dstId();
+                if(dstId == dfg->id()){
+                    numOut++;
+                    drivesOut = true;
+                } else if(!part.count(dstId) && liveNodes.count(dstId)){
+                    cut = true;
+                }
+            }
+            numOut += (cut && !drivesOut); // share the DFG output port if any
+        }
+    }
+    if(first){
+        for(auto& elem : dfg->outputEdges()){
+            DFGEdge* e = dfg->edge(elem.second);
+            if(e->srcId() == dfg->id()){
+                ins.emplace(e->srcId(), e->srcPortIdx());
+                numOut++;
+            }
+        }
+    }
+    return std::make_pair((int)ins.size(), numOut);
+}
+
+
+// max node number of each operation in one sub-DFG, the GPE nodes supporting the operation times fillRatio
+static std::map<std::string, int> maxOpNodeNum(ADG* adg, double fillRatio){
+    std::map<std::string, int> maxOpNodes; // <operation, max node number>
+    for(auto& elem : adg->nodes()){
+        if(elem.second->type() == "GPE"){
+            for(auto& op : dynamic_cast<GPENode*>(elem.second)->operations()){
+                maxOpNodes[op]++;
+            }
+        }
+    }
+    for(auto& elem : maxOpNodes){
+        elem.second *= fillRatio;
+    }
+    return maxOpNodes;
+}
+
+
+// assign the live nodes to the sub-DFGs in topological order, preferring the ones fed by the current sub-DFG
+// each sub-DFG has at most maxNodes nodes, maxOpNodes nodes of each operation and fits the ADG I/O ports
+// topoIdx: <node-id, topological order index> of the live nodes
+// partOf: <node-id, sub-DFG index>
+// return the sub-DFG number, 0 if some node cannot fit
+static int assignParts(DFG* dfg, ADG* adg, int maxNodes, std::map<std::string, int>& maxOpNodes, 
+                       const std::map<int, int>& topoIdx, std::map<int, int>& partOf){
+    int numParts = 0;
+    std::set<int> part; // nodes of the current sub-DFG
+    std::map<std::string, int> opCnt; // <operation, node number> of the current sub-DFG
+    while(partOf.size() < topoIdx.size()){
+        // ready nodes: all the src nodes are assigned, sorted by the number of the input edges from the current sub-DFG
+        std::vector<std::pair<int, int>> ready; // <-edge-number, node-id>
+        for(DFGNode* node : dfg->topoNodes()){
+            if(partOf.count(node->id())){
+                continue;
+            }
+            bool isReady = true;
+            int numInner = 0;
+            for(auto& elem : node->inputs()){
+                int srcId = elem.second.first;
+                if(srcId != dfg->id() && !partOf.count(srcId)){
+                    isReady = false;
+                    break;
+                }
+                numInner += part.count(srcId);
+            }
+            if(isReady){
+                ready.push_back(std::make_pair(-numInner, topoIdx.at(node->id())));
+            }
+        }
+        std::sort(ready.begin(), ready.end());
+        bool added = false;
+        for(auto& elem : ready){
+            DFGNode* node = dfg->topoNodes()[elem.second];
+            std::string op = node->operation();
+            if(part.size() + 1 > maxNodes || opCnt[op] + 1 > maxOpNodes[op]){
+                continue;
+            }
+            part.emplace(node->id());
+            auto ioNum = partIONum(dfg, part, topoIdx, numParts == 0);
+            if(ioNum.first > adg->numInputs() || ioNum.second > adg->numOutputs()){
+                part.erase(node->id());
+                continue;
+            }
+            partOf[node->id()] = numParts;
+            opCnt[op]++;
+            added = true;
+            break;
+        }
+        if(!added){
+            if(part.empty()){ // one node cannot fit
+                return 0;
+            }
+            part.clear();
+            opCnt.clear();
+            numParts++;
+        }
+    }
+    if(!part.empty()){
+        numParts++;
+    }
+    return numParts;
+}
+
+
+// generate the sub-DFGs according to the node assignment, the values only flow from the former sub-DFGs to the latter ones
+// topoIdx: <node-id, topological order index> of the live nodes
+// partOf: <node-id, sub-DFG index>
+static std::vector<DFG*> buildSubDfgs(DFG* dfg, const std::map<int, int>& topoIdx, std::map<int, int>& partOf, int numParts){
+    std::vector<DFG*> subDfgs;
+    int maxEdgeId = dfg->edges().empty()? 0 : dfg->edges().rbegin()->first;
+    for(int p = 0; p < numParts; p++){
+        DFG* subDfg = new DFG();
+        subDfg->setId(dfg->id());
+        subDfg->setBitWidth(dfg->bitWidth());
+        std::map<std::pair<int, int>, int> inputIdx; // <<src-node-id, src-port-idx>, input index of the sub-DFG>
+        int numOut = 0;
+        // add the input edge from the src node in the former sub-DFG or the DFG input port
+        auto addInputEdge = [&](DFGEdge* e, int dstId, int dstPort){
+            auto src = std::make_pair(e->srcId(), e->srcPortIdx());
+            if(!inputIdx.count(src)){
+                int idx = inputIdx.size();
+                inputIdx[src] = idx;
+                subDfg->setInputName(idx, (src.first == dfg->id())? dfg->inputName(src.second) : cutValueName(dfg, src.first, src.second));
+            }
+            DFGEdge* newEdge = new DFGEdge(e->id());
+            newEdge->setEdge(subDfg->id(), inputIdx[src], dstId, dstPort);
+            subDfg->addEdge(newEdge);
+        };
+        for(DFGNode* node : dfg->topoNodes()){
+            if(partOf[node->id()] != p){
+                continue;
+            }
+            subDfg->addNode(copyDfgNode(node));
+        }
+        for(DFGNode* node : dfg->topoNodes()){
+            if(partOf[node->id()] != p){
+                continue;
+            }
+            for(auto& elem : node->inputEdges()){
+                DFGEdge* e = dfg->edge(elem.second);
+                if(e->srcId() != dfg->id() && partOf[e->srcId()] == p){
+                    DFGEdge* newEdge = new DFGEdge(e->id());
+                    newEdge->setEdge(e->srcId(), e->srcPortIdx(), e->dstId(), e->dstPortIdx());
+                    subDfg->addEdge(newEdge);
+                } else{
+                    addInputEdge(e, e->dstId(), e->dstPortIdx());
+                }
+            }
+            for(auto& elem : node->outputEdges()){
+                bool drivesOut = false;
+                bool cut = false;
+                for(int eid : elem.second){
+                    DFGEdge* e = dfg->edge(eid);
+                    if(e->dstId() == dfg->id()){
+                        DFGEdge* newEdge = new DFGEdge(eid);
+                        newEdge->setEdge(node->id(), elem.first, subDfg->id(), numOut);
+                        subDfg->addEdge(newEdge);
+                        subDfg->setOutputName(numOut++, dfg->outputName(e->dstPortIdx()));
+                        drivesOut = true;
+                    } else if(topoIdx.count(e->dstId()) && partOf[e->dstId()] > p){
+                        cut = true;
+                    }
+                }
+                if(cut && !drivesOut){
+                    DFGEdge* newEdge = new DFGEdge(++maxEdgeId);
+                    newEdge->setEdge(node->id(), elem.first, subDfg->id(), numOut);
+                    subDfg->addEdge(newEdge);
+                    subDfg->setOutputName(numOut++, cutValueName(dfg, node->id(), elem.first));
+                }
+            }
+        }
+        if(p == 0){ // DFG input-output passthrough
+            for(auto& elem : dfg->outputEdges()){
+                DFGEdge* e = dfg->edge(elem.second);
+                if(e->srcId() == dfg->id()){
+                    addInputEdge(e, subDfg->id(), numOut);
+                    subDfg->setOutputName(numOut++, dfg->outputName(elem.first));
+                }
+            }
+        }
+        subDfg->topoSortNodes();
+        subDfgs.push_back(subDfg);
+    }
+    return subDfgs;
+}
+
+
+// Temporal partitioning
+// split the DFG (without back edges) into a sequence of sub-DFGs mapped to the ADG one after another,
+// each sub-DFG fits the I/O ports, the GPE nodes and the GPE nodes supporting each operation,
+// fillRatio: ratio of the GPE nodes that can be used by one sub-DFG
+// the nodes are added to the current sub-DFG in topological order, preferring the ones fed by it to reduce the cut edges
+// the value carried between sub-DFGs is the output of the former sub-DFG and the input of the latter ones,
+// named after the DFG output port it drives or the src node (suffixed with "_<port-idx>" if port-idx > 0)
+// return the sub-DFGs in execution order, deleted outside; empty if some node cannot fit
+std::vector<DFG*> partitionDfg(DFG* dfg, ADG* adg, double fillRatio){
+    int maxNodes = adg->numGpeNodes() * fillRatio;
+    std::map<std::string, int> maxOpNodes = maxOpNodeNum(adg, fillRatio);
+    dfg->topoSortNodes();
+    std::map<int, int> topoIdx; // <node-id, topological order index>, only the live nodes
+    int idx = 0;
+    for(DFGNode* node : dfg->topoNodes()){
+        topoIdx[node->id()] = idx++;
+    }
+    std::map<int, int> partOf; // <node-id, sub-DFG index>
+    int numParts = assignParts(dfg, adg, maxNodes, maxOpNodes, topoIdx, partOf);
+    if(numParts == 0){
+        return {};
+    }
+    return buildSubDfgs(dfg, topoIdx, partOf, numParts);
+}
+
+
+// Spatial partitioning
+// split the DFG (without back edges) across numArrays ADG instances joined by their I/O ports and running concurrently,
+// the nodes are first assigned with the node number balanced among the ADG instances if possible,
+// then the nodes are moved to the neighboring sub-DFGs to reduce the latency-weighted cut cost
+std::vector<DFG*> partitionDfgSpatial(DFG* dfg, ADG* adg, int numArrays, int interLat, double fillRatio){
+    int maxNodes = adg->numGpeNodes() * fillRatio;
+    std::map<std::string, int> maxOpNodes = maxOpNodeNum(adg, fillRatio);
+    dfg->topoSortNodes();
+    std::map<int, int> topoIdx; // <node-id, topological order index>, only the live nodes
+    int idx = 0;
+    for(DFGNode* node : dfg->topoNodes()){
+        topoIdx[node->id()] = idx++;
+    }
+    // initial assignment, relax the node number of each sub-DFG until fitting the ADG instances
+    std::map<int, int> partOf; // <node-id, sub-DFG index>
+    int numParts = 0;
+    int balanced = std::min(maxNodes, (int)(topoIdx.size() + numArrays - 1) / numArrays);
+    int step = std::max(1, balanced / 8);
+    for(int cap = balanced; ; cap = std::min(maxNodes, cap + step)){
+        partOf.clear();
+        numParts = assignParts(dfg, adg, cap, maxOpNodes, topoIdx, partOf);
+        if((numParts > 0 && numParts <= numArrays) || cap == maxNodes){
+            break;
+        }
+    }
+    if(numParts == 0 || numParts > numArrays){
+        return {};
+    }
+    // ASAP/ALAP levels of the live nodes, unit latency for each node
+    std::map<int, int> asap, alap;
+    int critLen = 0;
+    for(DFGNode* node : dfg->topoNodes()){
+        int lev = 0;
+        for(auto& elem : node->inputEdges()){
+            int srcId = dfg->edge(elem.second)->srcId();
+            if(topoIdx.count(srcId)){
+                lev = std::max(lev, asap[srcId] + 1);
+            }
+        }
+        asap[node->id()] = lev;
+        critLen = std::max(critLen, lev);
+    }
+    for(auto iter = dfg->topoNodes().rbegin(); iter != dfg->topoNodes().rend(); iter++){
+        DFGNode* node = *iter;
+        int lev = critLen;
+        for(auto& elem : node->outputEdges()){
+            for(int eid : elem.second){
+                int dstId = dfg->edge(eid)->dstId();
+                if(topoIdx.count(dstId)){
+                    lev = std::min(lev, alap[dstId] - 1);
+                }
+            }
+        }
+        alap[node->id()] = lev;
+    }
+    // cut cost of the value <node-id, port-idx>: weight x number of the other sub-DFGs consuming it
+    // weight: 1 + the latency added to the critical path if the value crosses the ADG instances
+    auto valueCost = [&](int id, int port){
+        int minSlack = INT_MAX;
+        std::set<int> dstParts;
+        for(int eid : dfg->node(id)->outputEdge(port)){
+            int dstId = dfg->edge(eid)->dstId();
+            if(topoIdx.count(dstId)){
+                minSlack = std::min(minSlack, alap[dstId] - asap[id] - 1);
+                if(partOf[dstId] != partOf[id]){
+                    dstParts.emplace(partOf[dstId]);
+                }
+            }
+        }
+        return (int)dstParts.size() * (1 + std::max(0, interLat - minSlack));
+    };
+    // cut cost of the values produced or consumed by the node
+    auto nodeCost = [&](DFGNode* node){
+        std::set<std::pair<int, int>> values;
+        for(auto& elem : node->outputEdges()){
+            values.emplace(node->id(), elem.first);
+        }
+        for(auto& elem : node->inputs()){
+            if(elem.second.first != dfg->id()){
+                values.insert(elem.second);
+            }
+        }
+        int cost = 0;
+        for(auto& value : values){
+            cost += valueCost(value.first, value.second);
+        }
+        return cost;
+    };
+    // if all the sub-DFGs fit the ADG I/O ports
+    auto fitIO = [&](){
+        std::vector<std::set<int>> parts(numParts);
+        for(auto& elem : topoIdx){
+            parts[partOf[elem.first]].emplace(elem.first);
+        }
+        for(int p = 0; p < numParts; p++){
+            auto ioNum = partIONum(dfg, parts[p], topoIdx, p == 0);
+            if(ioNum.first > adg->numInputs() || ioNum.second > adg->numOutputs()){
+                return false;
+            }
+        }
+        return true;
+    };
+    std::vector<int> nodeCnt(numParts, 0);
+    std::vector<std::map<std::string, int>> opCnt(numParts); // <operation, node number> of each sub-DFG
+    for(auto& elem : topoIdx){
+        DFGNode* node = dfg->node(elem.first);
+        nodeCnt[partOf[node->id()]]++;
+        opCnt[partOf[node->id()]][node->operation()]++;
+    }
+    // refinement, move the node to the former/latter sub-DFG if reducing the cut cost, keep the values flowing forward
+    bool improved = true;
+    for(int round = 0; improved && round < 16; round++){
+        improved = false;
+        for(DFGNode* node : dfg->topoNodes()){
+            int id = node->id();
+            std::string op = node->operation();
+            for(int q : {partOf[id] - 1, partOf[id] + 1}){
+                int p = partOf[id];
+                if(q < 0 || q >= numParts || nodeCnt[q] + 1 > maxNodes || opCnt[q][op] + 1 > maxOpNodes[op]){
+                    continue;
+                }
+                bool legal = true;
+                for(auto& elem : node->inputs()){
+                    int srcId = elem.second.first;
+                    legal &= !topoIdx.count(srcId) || partOf[srcId] <= q;
+                }
+                for(auto& elem : node->outputEdges()){
+                    for(int eid : elem.second){
+                        int dstId = dfg->edge(eid)->dstId();
+                        legal &= !topoIdx.count(dstId) || partOf[dstId] >= q;
+                    }
+                }
+                if(!legal){
+                    continue;
+                }
+                int oldCost = nodeCost(node);
+                partOf[id] = q;
+                if(nodeCost(node) >= oldCost || !fitIO()){
+                    partOf[id] = p;
+                    continue;
+                }
+                nodeCnt[p]--;
+                opCnt[p][op]--;
+                nodeCnt[q]++;
+                opCnt[q][op]++;
+                improved = true;
+                break;
+            }
+        }
+    }
+    // remove the empty sub-DFGs
+    std::map<int, int> partIdx; // <old index, new index>
+    for(int p = 0; p < numParts; p++){
+        if(nodeCnt[p] > 0){
+            int newIdx = partIdx.size();
+            partIdx[p] = newIdx;
+        }
+    }
+    for(auto& elem : partOf){
+        elem.second = partIdx[elem.second];
+    }
+    return buildSubDfgs(dfg, topoIdx, partOf, partIdx.size());
+}
+
+
+// add the simplification, folding, CSE and DCE passes,
+// ADG: the data width and the supported operations
+void DFGPassManager::addDefaultPasses(ADG* adg){
+    int bitWidth = adg->bitWidth();
+    // MUL by power of two is replaced with SHL only if no fewer GPEs support SHL than MUL
+    int numShl = 0;
+    int numMul = 0;
+    for(auto& elem : adg->nodes()){
+        if(elem.second->type() == "GPE"){
+            auto node = dynamic_cast<GPENode*>(elem.second);
+            numShl += node->opCapable("SHL");
+            numMul += node->opCapable("MUL");
+        }
+    }
+    bool shlPreferred = numShl > 0 && numShl >= numMul;
+    addPass("algebraic-simplification", [=](DFG* dfg){ return simplifyAlgebra(dfg, bitWidth, shlPreferred); });
+    addPass("constant-folding", [=](DFG* dfg){ return foldConstants(dfg, bitWidth); });
+    addPass("common-subexpression-elimination", eliminateCommonSubexpr);
+    addPass("dead-node-elimination", eliminateDeadNodes);
+}
+
+
+// run the pipeline, return true if the DFG is modified
+bool DFGPassManager::run(DFG* dfg){
+    bool modified = false;
+    for(int round = 0; round < _maxRounds; round++){
+        bool changed = false;
+        for(auto& pass : _passes){
+            if(pass.second(dfg)){
+                spdlog::debug("DFG pass {} modified the DFG, round {}", pass.first, round);
+                changed = true;
+            }
+        }
+        if(!changed){
+            break;
+        }
+        modified = true;
+    }
+    dfg->topoSortNodes();
+    return modified;
+}
@@ -197,6 +197,10 @@ DFG* DFGIR::parseDFGDot(std::string filename){
                 } else{
                     edge->setEdge(nodeId(srcName), srcPort, nodeId(dstName), dstPort);
                 }
+                int idx4 = line.find("iter_dist=");
+                if(idx4 != std::string::npos){ // loop-carried dependence, e.g. [operand=1, iter_dist=1]
+                    edge->setIterDist(std::stoi(line.substr(idx4+10)));
+                }
                 dfg->addEdge(edge);
             }         
         }
@@ -278,6 +282,9 @@ DFG* DFGIR::parseDFGJson(std::string filename){
             } else{
                 edge->setEdge(srcId, srcPort, dstId, dstPort);
             }
+            if(edgeJson.contains("iter_dist")){ // loop-carried dependence
+                edge->setIterDist(std::stoi(edgeJson["iter_dist"].get<std::string>()));
+            }
             dfg->addEdge(edge);
         }         
     }
@@ -8,7 +8,9 @@
 #include "op/operations.h"
 #include "ir/adg_ir.h"
 #include "ir/dfg_ir.h"
+#include "dfg/dfg_transform.h"
 #include "mapper/mapper_sa.h"
+#include "mapper/mapper_multi.h"
 #include "spdlog/spdlog.h"
 #include "spdlog/cfg/argv.h"
 
@@ -54,21 +56,37 @@ int main(int argc, char* argv[]) {
         {"obj-opt",         required_argument, nullptr, 'o',},  // true/false
         {"timeout-ms",      required_argument, nullptr, 't',},
         {"max-iters",       required_argument, nullptr, 'i',},
+        {"exact-max-nodes", required_argument, nullptr, 'e',},  // max DFG node number to run the exact search
+        {"dfg-opt",         required_argument, nullptr, 'g',},  // true/false
+        {"tree-height-reduce", required_argument, nullptr, 'r',},  // true/false
+        {"replicate",       required_argument, nullptr, 'k',},  // DFG copy number, 0: as many as the ADG fits
+        {"co-map",          required_argument, nullptr, 's',},  // true/false, map all the DFGs together
+        {"regions",         required_argument, nullptr, 'x',},  // GPE region of each co-mapped DFG, "minX:minY:maxX:maxY,..."
+        {"arrays",          required_argument, nullptr, 'n',},  // number of the ADG instances joined by their I/O ports
+        {"inter-array-lat", required_argument, nullptr, 'l',},  // latency of the link between two ADG instances
         {"op-file",         required_argument, nullptr, 'p',},
         {"adg-file",        required_argument, nullptr, 'a',},
         {"dfg-files",       required_argument, nullptr, 'd',},  // can input multiple files, separated by " " or ","
         {0, 0, 0, 0,}
     };
-    static char* const short_options = (char *)"c:m:o:t:i:p:a:d:";
+    static char* const short_options = (char *)"c:m:o:t:i:e:g:r:k:s:x:n:l:p:a:d:";
 
     std::string op_fn;  // "resources/ops/operations.json";  // operations file name
     std::string adg_fn; // "resources/adgs/my_cgra_test.json"; // ADG filename
     std::vector<std::string> dfg_fns; // "resources/dfgs/conv3.dot"; // DFG filenames
     int timeout_ms = 3600000;
     int max_iters = 2000;
+    int exact_max_nodes = 16;
     bool dumpConfig = true;
     bool dumpMappedViz = true;
     bool objOpt = true;
+    bool dfgOpt = true;
+    bool treeHeightReduce = true;
+    int replicate = 1;
+    bool coMap = false;
+    int numArrays = 1;
+    int interArrayLat = 2;
+    std::vector<DFGNodeRegion> regions; // GPE region of each co-mapped DFG
     std::string resultDir = "";
 
     int opt;
@@ -80,8 +98,25 @@ int main(int argc, char* argv[]) {
             case 'o': std::istringstream(optarg) >> std::boolalpha >> objOpt; break;
             case 't': timeout_ms = atoi(optarg); break;
             case 'i': max_iters = atoi(optarg); break;
+            case 'e': exact_max_nodes = atoi(optarg); break;
+            case 'g': std::istringstream(optarg) >> std::boolalpha >> dfgOpt; break;
+            case 'r': std::istringstream(optarg) >> std::boolalpha >> treeHeightReduce; break;
+            case 'k': replicate = atoi(optarg); break;
+            case 's': std::istringstream(optarg) >> std::boolalpha >> coMap; break;
+            case 'x': 
+                for(auto& str : split(optarg, "[\\s,]+")){
+                    auto vals = split(str, ":");
+                    if(vals.size() != 4){
+                        std::cout << "Invalid region: " << str << std::endl; 
+                        exit(1);
+                    }
+                    regions.push_back({std::stoi(vals[0]), std::stoi(vals[1]), std::stoi(vals[2]), std::stoi(vals[3])});
+                }
+                break;
             case 'p': op_fn = optarg; break;
             case 'a': adg_fn = optarg; break;
+            case 'n': numArrays = atoi(optarg); break;
+            case 'l': interArrayLat = atoi(optarg); break;
             case 'd': dfg_fns = split(optarg, "[\\s,?]+"); break;            
             case '?': std::cout << "Unknown option: " << optopt << std::endl; exit(1);
         }
@@ -112,18 +147,144 @@ int main(int argc, char* argv[]) {
 
     // map DFG to ADG
     MapperSA mapper(adg, timeout_ms, max_iters, objOpt);
+    mapper.setExactMaxNodes(exact_max_nodes);
     // MapperSA mapper(adg, dfg, 3600000, 2000);
+    // pre-mapping DFG optimization
+    auto optimizeDfg = [&](DFG* dfg){
+        DFGPassManager passMgr;
+        if(dfgOpt){
+            passMgr.addDefaultPasses(adg);
+        }
+        if(treeHeightReduce){
+            passMgr.addPass("tree-height-reduction", reduceTreeHeight);
+        }
+        if(passMgr.run(dfg)){
+            std::cout << "Optimize DFG, node number: " << dfg->nodes().size() << ", edge number: " << dfg->edges().size() << std::endl;
+        }
+    };
     int numDfg = dfg_fns.size();
+    if(coMap){ // merge the DFGs into one DFG, each DFG in its own region if given, and map them together
+        std::vector<DFGIR*> dfgIrs;
+        std::vector<DFG*> dfgs;
+        for(int k = 0; k < numDfg; k++){
+            std::cout << "Parse DFG: " << dfg_fns[k] << std::endl;
+            DFGIR* dfg_ir = new DFGIR(dfg_fns[k]);
+            DFG* dfg = dfg_ir->getDFG();
+            optimizeDfg(dfg);
+            if(k < regions.size()){
+                for(auto& elem : dfg->nodes()){
+                    elem.second->setRegion(regions[k]);
+                }
+            }
+            dfgIrs.push_back(dfg_ir);
+            dfgs.push_back(dfg);
+        }
+        DFG* mergedDfg = mergeDfgs(dfgs);
+        std::cout << "Co-map " << numDfg << " DFGs, node number: " << mergedDfg->nodes().size() << std::endl;
+        mapper.setDFG(mergedDfg);
+        bool succeed = mapper.execute(dumpConfig, dumpMappedViz, fileDir(dfg_fns[0]), "_comap");
+        delete mergedDfg;
+        for(auto dfg_ir : dfgIrs){
+            delete dfg_ir;
+        }
+        return !succeed;
+    }
+    // elapsed time (ms) since start
+    auto elapsedMS = [](std::chrono::steady_clock::time_point start){
+        return (double)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    };
     int numSucceed = 0;
     for(auto& dfg_fn : dfg_fns){
         std::cout << "Parse DFG: " << dfg_fn << std::endl;
         DFGIR dfg_ir(dfg_fn);
         DFG* dfg = dfg_ir.getDFG();
+        optimizeDfg(dfg);
         // dfg->print();
         // map DFG to ADG
-        mapper.setDFG(dfg);
         resultDir = fileDir(dfg_fn);
-        bool succeed = mapper.execute(dumpConfig, dumpMappedViz, resultDir);
+        bool succeed;
+        if(mapper.maxCopies(adg, dfg) == 0 && !dfg->hasBackEdge() && numArrays > 1){ // too large, map the sub-DFGs across the ADG instances
+            MultiArrayMapper sysMapper(&mapper, numArrays, interArrayLat);
+            succeed = sysMapper.execute(dfg, dumpConfig, dumpMappedViz, resultDir);
+        } else if(mapper.maxCopies(adg, dfg) == 0 && !dfg->hasBackEdge()){ // too large, map the sub-DFGs one after another
+            succeed = false;
+            // share one timeout: each fill ratio tries an even share of the remaining time, 
+            // split evenly among its remaining sub-DFGs
+            auto partStart = std::chrono::steady_clock::now();
+            for(int fill = 100; fill >= 50 && !succeed; fill -= 10){ // use fewer GPE nodes if one sub-DFG fails
+                double fillTime = (timeout_ms - elapsedMS(partStart)) / ((fill - 50) / 10 + 1);
+                if(fillTime <= 0){
+                    break;
+                }
+                auto fillStart = std::chrono::steady_clock::now();
+                std::vector<DFG*> subDfgs = partitionDfg(dfg, adg, fill / 100.0);
+                if(subDfgs.empty()){
+                    break;
+                }
+                std::cout << "Partition the DFG into " << subDfgs.size() << " sub-DFGs, GPE fill ratio: " << fill << "%" << std::endl;
+                succeed = true;
+                for(int i = 0; i < subDfgs.size() && succeed; i++){
+                    double remainTime = fillTime - elapsedMS(fillStart);
+                    if(remainTime <= 0){
+                        succeed = false;
+                        break;
+                    }
+                    mapper.setTimeOut(remainTime / (subDfgs.size() - i));
+                    std::cout << "Map sub-DFG " << i << ", node number: " << subDfgs[i]->nodes().size() << std::endl;
+                    mapper.setDFG(subDfgs[i]);
+                    succeed = mapper.execute(dumpConfig, dumpMappedViz, resultDir, "_" + std::to_string(i));
+                }
+                if(succeed){
+                    std::cout << "Configurations (sub-DFGs): " << subDfgs.size() << std::endl;
+                }
+                for(auto subDfg : subDfgs){
+                    delete subDfg;
+                }
+            }
+            mapper.setTimeOut(timeout_ms);
+        } else if(replicate == 1){
+            mapper.setDFG(dfg);
+            succeed = mapper.execute(dumpConfig, dumpMappedViz, resultDir);
+        } else{ // map multiple copies of the DFG together, reduce the copy number until succeed
+            int copies = mapper.maxCopies(adg, dfg);
+            if(replicate > 0){
+                copies = std::min(copies, replicate);
+            }
+            std::vector<DFG*> repDfgs;
+            succeed = false;
+            // share one timeout: half of it is reserved for the single copy, 
+            // the other copy numbers split the rest evenly, the single copy tries all the remaining time
+            auto repStart = std::chrono::steady_clock::now();
+            for(; copies >= 1; copies--){
+                double remainTime = timeout_ms - elapsedMS(repStart);
+                if(remainTime <= 0){
+                    break;
+                }
+                double copyTime = (copies == 1)? remainTime : (remainTime - timeout_ms / 2.0) / (copies - 1);
+                if(copyTime <= 0){
+                    continue;
+                }
+                mapper.setTimeOut(copyTime);
+                DFG* repDfg = dfg;
+                if(copies > 1){
+                    repDfg = replicateDfg(dfg, copies);
+                    repDfgs.push_back(repDfg);
+                }
+                std::cout << "Map " << copies << " copies of the DFG" << std::endl;
+                mapper.setDFG(repDfg);
+                succeed = mapper.execute(dumpConfig, dumpMappedViz, resultDir);
+                if(succeed){
+                    break;
+                }
+            }
+            mapper.setTimeOut(timeout_ms);
+            if(succeed){
+                std::cout << "Parallelism (DFG copies): " << copies << std::endl;
+            }
+            for(auto repDfg : repDfgs){
+                delete repDfg;
+            }
+        }
         if(!succeed){
             break;
         }
@@ -9,7 +9,7 @@ Mapper::Mapper(ADG* adg): _adg(adg) {
 Mapper::Mapper(ADG* adg, DFG* dfg): _adg(adg), _dfg(dfg) {
     initializeAdg();
     initializeDfg();
-    _mapping = new Mapping(adg, dfg);
+    _mapping = new Mapping(adg, dfg, _routeTemplates);
     // initializeCandidates();
     _isDfgModified = false;
     sortDfgNodeInPlaceOrder();
@@ -22,6 +22,9 @@ Mapper::~Mapper(){
     if(_dfgModified != nullptr){
         delete _dfgModified;
     }
+    if(_routeTemplates != nullptr){
+        delete _routeTemplates;
+    }
 }
 
 // set DFG and initialize DFG
@@ -32,7 +35,7 @@ void Mapper::setDFG(DFG* dfg, bool modify){
     if(_mapping != nullptr){
         delete _mapping;
     }
-    _mapping = new Mapping(_adg, dfg);
+    _mapping = new Mapping(_adg, dfg, _routeTemplates, _ii);
     // initializeCandidates();
     if(modify){
         setDfgModified(dfg);
@@ -63,6 +66,12 @@ void Mapper::setDfgModified(DFG* dfg){
 void Mapper::initializeAdg(){
     // std::cout << "Initialize ADG\n";
     calAdgNodeDist();
+    calGpeTiles();
+    if(isLargeAdg()){ // only cache the short paths of the large ADG
+        _routeTemplates = new RouteTemplates(_adg, 3, 4 * TILE_SIZE);
+    } else{
+        _routeTemplates = new RouteTemplates(_adg);
+    }
 }
 
 
@@ -114,24 +123,24 @@ void Mapper::initializeDfg(){
 
 
 // calculate the shortest path among ADG nodes
+// Dijkstra from each GPE/IB node, only routing through GIB nodes
 void Mapper::calAdgNodeDist(){
-    // map ADG node id to continuous index starting from 0
-    std::map<int, int> _adgNodeId2Idx;
-    // distances among ADG nodes
-    std::vector<std::vector<int>> _adgNodeDist; // [node-idx][node-idx]
     int i = 0;
-    // if the ADG node with the index is GIB
-    std::map<int, bool> adgNodeIdx2GIB;
+    // if the ADG node is GIB
+    std::map<int, bool> adgNodeGIB;
+    _adgNodeId2Idx.clear();
     for(auto& node : _adg->nodes()){
-        adgNodeIdx2GIB[i] = (node.second->type() == "GIB");
-        _adgNodeId2Idx[node.first] = i++;
+        adgNodeGIB[node.first] = (node.second->type() == "GIB");
+        if(!adgNodeGIB[node.first]){
+            _adgNodeId2Idx[node.first] = i++;
+        }
     }
-    int n = i; // total node number
+    int n = i; // non-GIB node number
     int inf = 0x7fffffff;
     _adgNodeDist.assign(n, std::vector<int>(n, inf));
+    // links among ADG nodes, <src-node-id, <dst-node-id, dist>>
+    std::map<int, std::map<int, int>> adgLinks;
     for(auto& node : _adg->nodes()){
-        int idx = _adgNodeId2Idx[node.first];
-        _adgNodeDist[idx][idx] = 0;
         for(auto& src : node.second->inputs()){
             int srcId = src.second.first;
             if(srcId == _adg->id()){
@@ -145,40 +154,44 @@ void Mapper::calAdgNodeDist(){
                     dist = 2;
                 }
             }
-            int srcIdx = _adgNodeId2Idx[srcId];
-            _adgNodeDist[srcIdx][idx] = dist;
-        }
-    }
-    // Floyd algorithm
-    for (int k = 0; k < n; ++k) {
-        if(adgNodeIdx2GIB[k]){
-            for (int i = 0; i < n; ++i) {
-                for (int j = 0; j < n; ++j) {
-                    if (_adgNodeDist[i][k] < inf && _adgNodeDist[k][j] < inf &&
-                        _adgNodeDist[i][j] > _adgNodeDist[i][k] + _adgNodeDist[k][j]) {
-                        _adgNodeDist[i][j] = _adgNodeDist[i][k] + _adgNodeDist[k][j];
-                    }
-                }
+            auto& links = adgLinks[srcId];
+            if(!links.count(node.first) || links[node.first] > dist){
+                links[node.first] = dist;
             }
-        }        
+        }
     }
-
-    // shortest distance between two ADG nodes (GPE/IOB nodes)
     for(auto& inode : _adg->nodes()){
-        if(inode.second->type() == "GIB" || inode.second->type() == "OB"){
+        auto itype = inode.second->type();
+        if(itype == "GIB" || itype == "OB"){
             continue;
         }
-        int i = _adgNodeId2Idx[inode.first];
-        for(auto& jnode : _adg->nodes()){
-            if(jnode.second->type() == "GIB" || jnode.second->type() == "IB" ||
-              (inode.second->type() == "IB" && jnode.second->type() == "OB")){
+        int srcId = inode.first;
+        std::map<int, int> dist; // <node-id, dist>
+        typedef std::pair<int, int> QueElem; // <dist, node-id>, min dist first
+        std::priority_queue<QueElem, std::vector<QueElem>, std::greater<QueElem>> nodeQue;
+        dist[srcId] = 0;
+        nodeQue.push(std::make_pair(0, srcId));
+        while(!nodeQue.empty()){
+            int d = nodeQue.top().first;
+            int id = nodeQue.top().second;
+            nodeQue.pop();
+            if(d > dist[id] || (id != srcId && !adgNodeGIB[id])){ // stale element or non-GIB end node
                 continue;
             }
-            int j = _adgNodeId2Idx[jnode.first];
-            _adgNode2NodeDist[std::make_pair(inode.first, jnode.first)] = _adgNodeDist[i][j];
-            // std::cout << inode.first << "," << jnode.first << ": " << _adgNodeDist[i][j] << "  ";
+            for(auto& link : adgLinks[id]){
+                int nd = d + link.second;
+                if(!dist.count(link.first) || dist[link.first] > nd){
+                    dist[link.first] = nd;
+                    nodeQue.push(std::make_pair(nd, link.first));
+                }
+            }
+        }
+        int idx = _adgNodeId2Idx[srcId];
+        for(auto& elem : dist){
+            if(!adgNodeGIB[elem.first]){
+                _adgNodeDist[idx][_adgNodeId2Idx[elem.first]] = elem.second;
+            }
         }
-        // std::cout << std::endl;
     }
 
     // // shortest distance between ADG node (GPE node) and the ADG IO
@@ -206,8 +219,42 @@ void Mapper::calAdgNodeDist(){
 
 // get the shortest distance between two ADG nodes
 int Mapper::getAdgNodeDist(int srcId, int dstId){
-    // return _adgNodeDist[_adgNodeId2Idx[srcId]][_adgNodeId2Idx[dstId]];
-    return _adgNode2NodeDist[std::make_pair(srcId, dstId)];
+    auto srcIter = _adgNodeId2Idx.find(srcId);
+    auto dstIter = _adgNodeId2Idx.find(dstId);
+    if(srcIter == _adgNodeId2Idx.end() || dstIter == _adgNodeId2Idx.end()){
+        return 0;
+    }
+    return _adgNodeDist[srcIter->second][dstIter->second];
+}
+
+
+// divide the GPE nodes into tiles according to their locations
+void Mapper::calGpeTiles(){
+    // column/row index of the GPE locations
+    std::map<int, int> col, row;
+    for(auto& node : _adg->nodes()){
+        if(node.second->type() == "GPE"){
+            col[node.second->x()] = 0;
+            row[node.second->y()] = 0;
+        }
+    }
+    int i = 0;
+    for(auto& elem : col){
+        elem.second = i++;
+    }
+    i = 0;
+    for(auto& elem : row){
+        elem.second = i++;
+    }
+    _gpeTiles.clear();
+    _gpeNodeTile.clear();
+    for(auto& node : _adg->nodes()){
+        if(node.second->type() == "GPE"){
+            auto tile = std::make_pair(col[node.second->x()] / TILE_SIZE, row[node.second->y()] / TILE_SIZE);
+            _gpeTiles[tile].push_back(node.first);
+            _gpeNodeTile[node.first] = tile;
+        }
+    }
 }
 
 // // get the shortest distance between ADG node and ADG input
@@ -232,7 +279,7 @@ int Mapper::calCandidatesCnt(DFGNode* dfgNode, int maxCandidates){
         }
         GPENode* gpeNode = dynamic_cast<GPENode*>(adgNode);
         // check if the DFG node operationis supported
-        if(gpeNode->opCapable(dfgNode->operation())){
+        if(isCapable(dfgNode, gpeNode)){
             candidatesCnt++;
         }
     }
@@ -243,6 +290,7 @@ int Mapper::calCandidatesCnt(DFGNode* dfgNode, int maxCandidates){
 void Mapper::sortDfgNodeInPlaceOrder(){
     std::map<int, int> candidatesCnt; // <dfgnode-id, count>
     dfgNodeIdPlaceOrder.clear();
+    calDfgSlack();
     // topological order
     for(auto node : _dfg->topoNodes()){ 
         dfgNodeIdPlaceOrder.push_back(node->id());
@@ -251,14 +299,81 @@ void Mapper::sortDfgNodeInPlaceOrder(){
         candidatesCnt[node->id()] = cnt;
     }
     // std::cout << std::endl;
-    // sort DFG nodes according to their candidate numbers
+    // sort DFG nodes according to their candidate numbers, then their slacks
+    // the critical path is placed first and determines the max latency, the others fit around it
     // std::random_shuffle(dfgNodeIds.begin(), dfgNodeIds.end()); // randomly sort will cause long routing paths
     std::stable_sort(dfgNodeIdPlaceOrder.begin(), dfgNodeIdPlaceOrder.end(), [&](int a, int b){
-        return candidatesCnt[a] <  candidatesCnt[b];
+        if(candidatesCnt[a] != candidatesCnt[b]){
+            return candidatesCnt[a] <  candidatesCnt[b];
+        }
+        return _dfgNodeSlack[a] < _dfgNodeSlack[b];
     });
 }
 
 
+// calculate the ASAP/ALAP latency and the slack of the DFG nodes and edges, ignoring the routing latency
+void Mapper::calDfgSlack(){
+    std::map<int, int> asap, alap;
+    int critLat = 0; // critical path latency
+    for(auto node : _dfg->topoNodes()){
+        int lat = 0;
+        for(auto& elem : node->inputEdges()){
+            DFGEdge* edge = _dfg->edge(elem.second);
+            if(edge->srcId() != _dfg->id() && !edge->isBackEdge()){
+                lat = std::max(lat, asap[edge->srcId()] + _dfg->node(edge->srcId())->opLatency());
+            }
+        }
+        asap[node->id()] = lat;
+        critLat = std::max(critLat, lat + node->opLatency());
+    }
+    auto& topoNodes = _dfg->topoNodes();
+    for(auto iter = topoNodes.rbegin(); iter != topoNodes.rend(); iter++){
+        auto node = *iter;
+        int lat = critLat;
+        for(auto& elem : node->outputEdges()){
+            for(int eid : elem.second){
+                DFGEdge* edge = _dfg->edge(eid);
+                if(edge->dstId() != _dfg->id() && !edge->isBackEdge()){
+                    lat = std::min(lat, alap[edge->dstId()]);
+                }
+            }
+        }
+        alap[node->id()] = lat - node->opLatency();
+    }
+    _dfgNodeSlack.clear();
+    _dfgEdgeSlack.clear();
+    for(auto node : topoNodes){
+        _dfgNodeSlack[node->id()] = alap[node->id()] - asap[node->id()];
+    }
+    for(auto& elem : _dfg->edges()){
+        DFGEdge* edge = elem.second;
+        if(edge->isBackEdge()){
+            continue;
+        }
+        int srcLat = (edge->srcId() == _dfg->id())? 0 : asap[edge->srcId()] + _dfg->node(edge->srcId())->opLatency();
+        int dstLat = (edge->dstId() == _dfg->id())? critLat : alap[edge->dstId()];
+        _dfgEdgeSlack[elem.first] = dstLat - srcLat;
+    }
+}
+
+
+// criticality weight of the DFG edge in the distance cost, 1 + max(0, CRIT_SLACK - slack), 1 for the back edges
+int Mapper::edgeCritWeight(int id){
+    auto iter = _dfgEdgeSlack.find(id);
+    if(iter == _dfgEdgeSlack.end()){
+        return 1;
+    }
+    return 1 + std::max(0, CRIT_SLACK - iter->second);
+}
+
+
+// if the DFG node can be mapped to the ADG node, i.e. the GPE node supporting its operation in its region
+bool Mapper::isCapable(DFGNode* dfgNode, ADGNode* adgNode){
+    return adgNode->type() == "GPE" && dynamic_cast<GPENode*>(adgNode)->opCapable(dfgNode->operation()) &&
+           dfgNode->inRegion(adgNode->x(), adgNode->y());
+}
+
+
 // ===== timestamp functions >>>>>>>>>
 void Mapper::setStartTime(){
     _start = std::chrono::steady_clock::now();
@@ -279,20 +394,8 @@ double Mapper::runningTimeMS(){
 
 
 // ==== map functions below >>>>>>>>
-// check if the DFG can be mapped to the ADG according to the resources
-bool Mapper::preMapCheck(ADG* adg, DFG* dfg){
-    // first, check the I/O port number
-    if(adg->numInputs() < dfg->numInputs() || adg->numOutputs() < dfg->numOutputs()){
-        std::cout << "This DFG has too many I/O port!\n";
-        return false;
-    }
-    // second, check the total node number
-    if(adg->numGpeNodes() < dfg->nodes().size()){
-        std::cout << "This DFG has too many nodes!\n";
-        return false;
-    }
-    // third, check if there are enough ADG nodes that can map the DFG nodes
-    // supported operation count of ADG
+// supported operation count of ADG, <operation, GPE number>
+static std::map<std::string, int> countAdgOps(ADG* adg){
     std::map<std::string, int> adgOpCnt; 
     for(auto& elem : adg->nodes()){       
         if(elem.second->type() == "GPE"){
@@ -306,7 +409,12 @@ bool Mapper::preMapCheck(ADG* adg, DFG* dfg){
             }
         }
     }
-    // operation count of DFG
+    return adgOpCnt;
+}
+
+
+// operation count of DFG, <operation, node number>
+static std::map<std::string, int> countDfgOps(DFG* dfg){
     std::map<std::string, int> dfgOpCnt; 
     for(auto& elem : dfg->nodes()){
         auto op = elem.second->operation();
@@ -317,21 +425,160 @@ bool Mapper::preMapCheck(ADG* adg, DFG* dfg){
             dfgOpCnt[op] = 1;
         }
     }
+    return dfgOpCnt;
+}
+
+
+// check if the DFG can be mapped to the ADG according to the resources
+bool Mapper::preMapCheck(ADG* adg, DFG* dfg){
+    // first, check the I/O port number
+    if(adg->numInputs() < dfg->numInputs() || adg->numOutputs() < dfg->numOutputs()){
+        std::cout << "This DFG has too many I/O port!\n";
+        return false;
+    }
+    // second, check the total node number
+    if(adg->numGpeNodes() < dfg->nodes().size()){
+        std::cout << "This DFG has too many nodes!\n";
+        return false;
+    }
+    // third, check if there are enough ADG nodes that can map the DFG nodes
+    // supported operation count of ADG
+    std::map<std::string, int> adgOpCnt = countAdgOps(adg); 
+    // operation count of DFG
+    std::map<std::string, int> dfgOpCnt = countDfgOps(dfg); 
     for(auto& elem : dfgOpCnt){
         if(adgOpCnt[elem.first] < elem.second){ 
             std::cout << "No enough ADG nodes to support " << elem.first << std::endl;
             return false; // there should be enough ADG nodes that support this operation
         }
     }
+    // fourth, check if there are enough GPE nodes in each region
+    std::map<std::vector<int>, std::vector<DFGNode*>> regionNodes; // <<minX, minY, maxX, maxY>, DFG nodes>
+    for(auto& elem : dfg->nodes()){
+        DFGNode* node = elem.second;
+        if(node->hasRegion()){
+            auto& region = node->region();
+            regionNodes[{region.minX, region.minY, region.maxX, region.maxY}].push_back(node);
+        }
+    }
+    for(auto& elem : regionNodes){
+        int numGpes = 0;
+        for(auto& adgElem : adg->nodes()){
+            ADGNode* adgNode = adgElem.second;
+            numGpes += adgNode->type() == "GPE" && elem.second[0]->inRegion(adgNode->x(), adgNode->y());
+        }
+        if(numGpes < elem.second.size()){
+            std::cout << "No enough GPE nodes in the region (" << elem.first[0] << ", " << elem.first[1] << ", " 
+                      << elem.first[2] << ", " << elem.first[3] << ")" << std::endl;
+            return false;
+        }
+    }
     return true;
 }
 
+
+// max number of the DFG copies that can be mapped to the ADG according to the resources
+// (I/O ports, GPE nodes and the GPE nodes supporting each operation), routing resources not considered
+int Mapper::maxCopies(ADG* adg, DFG* dfg){
+    int copies = INT_MAX;
+    if(dfg->numInputs() > 0){
+        copies = std::min(copies, adg->numInputs() / dfg->numInputs());
+    }
+    if(dfg->numOutputs() > 0){
+        copies = std::min(copies, adg->numOutputs() / dfg->numOutputs());
+    }
+    if(dfg->nodes().size() > 0){
+        copies = std::min(copies, adg->numGpeNodes() / (int)dfg->nodes().size());
+    }
+    std::map<std::string, int> adgOpCnt = countAdgOps(adg);
+    for(auto& elem : countDfgOps(dfg)){
+        copies = std::min(copies, adgOpCnt[elem.first] / elem.second);
+    }
+    return copies;
+}
+
+
+// if the recurrence cycles of the DFG meet the II, not considering the routing latency
+// longest-path Bellman-Ford on lat(v) >= lat(u) + opLat(v) - d * II, infeasible if there is a positive cycle
+static bool isIIFeasible(DFG* dfg, int ii){
+    std::map<int, int> lat; // <node-id, latency>
+    for(auto& elem : dfg->nodes()){
+        lat[elem.first] = elem.second->opLatency();
+    }
+    for(int i = 0; i <= dfg->nodes().size(); i++){
+        bool changed = false;
+        for(auto& elem : dfg->edges()){
+            DFGEdge* edge = elem.second;
+            if(edge->srcId() == dfg->id() || edge->dstId() == dfg->id()){ // DFG I/O port
+                continue;
+            }
+            int weight = dfg->node(edge->dstId())->opLatency() - edge->iterDist() * ii;
+            if(lat[edge->srcId()] + weight > lat[edge->dstId()]){
+                lat[edge->dstId()] = lat[edge->srcId()] + weight;
+                changed = true;
+            }
+        }
+        if(!changed){
+            return true;
+        }
+    }
+    return false;
+}
+
+
+// min initiation interval limited by the recurrence cycles (RecMII), not considering the routing latency
+// the cycle latency cannot exceed the II times the iteration distances of its back edges
+int Mapper::calRecMII(DFG* dfg){
+    int minII = 1;
+    int maxII = 1; // the latency of any cycle is not larger than the total operation latency
+    for(auto& elem : dfg->nodes()){
+        maxII += elem.second->opLatency();
+    }
+    while(minII < maxII){ // binary search, feasible for all the II not smaller than the RecMII
+        int ii = (minII + maxII) / 2;
+        if(isIIFeasible(dfg, ii)){
+            maxII = ii;
+        } else{
+            minII = ii + 1;
+        }
+    }
+    return minII;
+}
+
+
 // // map the DFG to the ADG
 // bool Mapper::mapping(){
 
 // }
 
 
+// map the DFG with back edges, increase the II from the RecMII until mapped
+// each II tries half of the remaining time, the last one tries all
+bool Mapper::mapperModulo(){
+    DFG* dfg = getDFG(); // restart from the original DFG for each II, pass-through nodes may be inserted
+    int recMII = calRecMII(dfg);
+    std::cout << "RecMII: " << recMII << std::endl;
+    double timeout = getTimeOut();
+    bool succeed = false;
+    for(int ii = recMII; ii <= recMII + MAX_II_SLACK && !succeed; ii++){
+        double remainTime = timeout - runningTimeMS();
+        if(remainTime <= 0){
+            break;
+        }
+        setTimeOut((ii == recMII + MAX_II_SLACK)? timeout : (timeout - remainTime/2));
+        _ii = ii;
+        setDFG(dfg); // reset the mapping with the new II
+        spdlog::warn("Try to map the DFG with II: {}", ii);
+        succeed = mapper();
+    }
+    setTimeOut(timeout);
+    if(succeed){
+        std::cout << "II: " << _ii << std::endl;
+    }
+    return succeed;
+}
+
+
 // mapper with running time
 bool Mapper::mapperTimed(){
     setStartTime();
@@ -340,7 +587,12 @@ bool Mapper::mapperTimed(){
         return false;
     }
     std::cout << "Pre-map checking passed!\n";
-    bool succeed = mapper();
+    bool succeed;
+    if(getDFG()->hasBackEdge()){ // loop-carried dependences, modulo mapping with II
+        succeed = mapperModulo();
+    } else{
+        succeed = mapper();
+    }
     std::cout << "Running time(s): " << runningTimeMS()/1000 << std::endl;
     return succeed;
 }
@@ -350,7 +602,8 @@ bool Mapper::mapperTimed(){
 // dumpConfig : dump configuration file
 // dumpMappedViz : dump mapped visual graph
 // resultDir: mapped result directory
-bool Mapper::execute(bool dumpConfig, bool dumpMappedViz, std::string resultDir){
+// resultSuffix: suffix of the result file names, e.g. config_0.bit
+bool Mapper::execute(bool dumpConfig, bool dumpMappedViz, std::string resultDir, std::string resultSuffix){
     std::cout << "Start mapping >>>>>>\n";
     bool res = mapperTimed();
     if(res){
@@ -361,14 +614,14 @@ bool Mapper::execute(bool dumpConfig, bool dumpMappedViz, std::string resultDir)
             dir = "results"; // default directory
         }
         if(dumpMappedViz){
-            Graphviz viz(_mapping, dir);
+            Graphviz viz(_mapping, dir, resultSuffix);
             viz.drawDFG();
             viz.drawADG();
             viz.dumpDFGIO(); 
         }
         if(dumpConfig){
             Configuration cfg(_mapping);
-            std::ofstream ofs(dir + "/config.bit");
+            std::ofstream ofs(dir + "/config" + resultSuffix + ".bit");
             cfg.dumpCfgData(ofs);
         }       
         std::cout << "Succeed to map DFG to ADG!<<<<<<\n" << std::endl;
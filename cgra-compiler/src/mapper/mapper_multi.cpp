@@ -0,0 +1,167 @@
+
+#include "mapper/mapper_multi.h"
+
+
+// schedule the start cycles of the ADG instances in data-flow order (ASAP), 
+// each one starts when its latest boundary input arrives, the earlier ones are delayed by the link buffers,
+// then postpone the ADG instance with more output boundaries than input ones to reduce the buffer delays
+// inLats/outLats: <I/O-name, I/O-latency> of each mapped sub-DFG
+void MultiArrayMapper::schedule(DFG* dfg, const std::vector<std::map<std::string, int>>& inLats, const std::vector<std::map<std::string, int>>& outLats){
+    int numParts = inLats.size();
+    std::map<std::string, int> producer; // <value-name, src ADG instance>
+    for(int p = 0; p < numParts; p++){
+        for(auto& elem : outLats[p]){
+            if(!producer.count(elem.first)){
+                producer[elem.first] = p;
+            }
+        }
+    }
+    std::set<std::string> dfgOutNames;
+    for(auto& elem : dfg->outputs()){
+        dfgOutNames.emplace(dfg->outputName(elem.first));
+    }
+    _startCycles.assign(numParts, 0);
+    _boundaries.clear();
+    for(int p = 0; p < numParts; p++){
+        for(auto& elem : inLats[p]){
+            if(producer.count(elem.first) && producer[elem.first] < p){
+                int q = producer[elem.first];
+                int arrival = _startCycles[q] + outLats[q].at(elem.first) + _interLat;
+                _startCycles[p] = std::max(_startCycles[p], arrival - elem.second);
+                _boundaries.push_back({elem.first, q, p, 0});
+            }
+        }
+    }
+    // buffer delay of each boundary
+    auto calDelays = [&](){
+        for(auto& bd : _boundaries){
+            int arrival = _startCycles[bd.srcArray] + outLats[bd.srcArray].at(bd.name) + _interLat;
+            bd.delay = _startCycles[bd.dstArray] + inLats[bd.dstArray].at(bd.name) - arrival;
+        }
+    };
+    // max cycle of the DFG outputs
+    auto calLatency = [&](){
+        _latency = 0;
+        for(int p = 0; p < numParts; p++){
+            for(auto& elem : outLats[p]){
+                if(dfgOutNames.count(elem.first)){
+                    _latency = std::max(_latency, _startCycles[p] + elem.second);
+                }
+            }
+        }
+    };
+    calDelays();
+    calLatency();
+    for(int p = numParts - 1; p >= 0; p--){
+        int numIn = 0;
+        int numOut = 0;
+        int shift = INT_MAX;
+        for(auto& bd : _boundaries){
+            if(bd.srcArray == p){
+                numOut++;
+                shift = std::min(shift, bd.delay);
+            } else if(bd.dstArray == p){
+                numIn++;
+            }
+        }
+        for(auto& elem : outLats[p]){ // not increase the system latency
+            if(dfgOutNames.count(elem.first)){
+                shift = std::min(shift, _latency - _startCycles[p] - elem.second);
+            }
+        }
+        if(numOut > numIn && shift > 0){
+            _startCycles[p] += shift;
+            calDelays();
+        }
+    }
+    calLatency();
+    _inputCycles.clear();
+    for(int p = numParts - 1; p >= 0; p--){
+        for(auto& elem : inLats[p]){
+            if(!producer.count(elem.first) || producer[elem.first] >= p){
+                _inputCycles[elem.first] = _startCycles[p] + elem.second;
+            }
+        }
+    }
+}
+
+
+// dump the start cycles, boundary delays and DFG input cycles
+void MultiArrayMapper::dumpSchedule(const std::string& filename){
+    std::ofstream ofs(filename);
+    ofs << "# latency: " << _latency << std::endl;
+    ofs << "# format: ADG-Instance-Index, Start-Cycle\n";
+    for(int p = 0; p < _startCycles.size(); p++){
+        ofs << p << ", " << _startCycles[p] << std::endl;
+    }
+    ofs << "# format: Value-Name, Src-ADG-Instance, Dst-ADG-Instance, Buffer-Delay\n";
+    for(auto& bd : _boundaries){
+        ofs << bd.name << ", " << bd.srcArray << ", " << bd.dstArray << ", " << bd.delay << std::endl;
+    }
+    ofs << "# format: DFG-Input-Name, Input-Cycle\n";
+    for(auto& elem : _inputCycles){
+        ofs << elem.first << ", " << elem.second << std::endl;
+    }
+}
+
+
+// map the DFG (without back edges) across the ADG instances, use fewer GPE nodes of each instance if some sub-DFG fails
+// the result files of ADG instance i are suffixed with "_a<i>", the system schedule is dumped into mapped_system.txt
+// the mapper timeout is shared: each fill ratio tries an even share of the remaining time, split evenly among its remaining sub-DFGs
+bool MultiArrayMapper::execute(DFG* dfg, bool dumpConfig, bool dumpMappedViz, std::string resultDir){
+    ADG* adg = _mapper->getADG();
+    double timeout = _mapper->getTimeOut();
+    auto elapsedMS = [](std::chrono::steady_clock::time_point start){
+        return (double)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    };
+    auto start = std::chrono::steady_clock::now();
+    bool succeed = false;
+    for(int fill = 100; fill >= 50 && !succeed; fill -= 10){
+        double fillTime = (timeout - elapsedMS(start)) / ((fill - 50) / 10 + 1);
+        if(fillTime <= 0){
+            break;
+        }
+        auto fillStart = std::chrono::steady_clock::now();
+        std::vector<DFG*> subDfgs = partitionDfgSpatial(dfg, adg, _numArrays, _interLat, fill / 100.0);
+        if(subDfgs.empty()){
+            break;
+        }
+        std::cout << "Partition the DFG across " << subDfgs.size() << " ADG instances, GPE fill ratio: " << fill << "%" << std::endl;
+        std::vector<std::map<std::string, int>> inLats, outLats;
+        succeed = true;
+        for(int i = 0; i < subDfgs.size() && succeed; i++){
+            double remainTime = fillTime - elapsedMS(fillStart);
+            if(remainTime <= 0){
+                succeed = false;
+                break;
+            }
+            _mapper->setTimeOut(remainTime / (subDfgs.size() - i));
+            std::cout << "Map sub-DFG " << i << " to ADG instance " << i << ", node number: " << subDfgs[i]->nodes().size() << std::endl;
+            _mapper->setDFG(subDfgs[i]);
+            succeed = _mapper->execute(dumpConfig, dumpMappedViz, resultDir, "_a" + std::to_string(i));
+            if(succeed){
+                Mapping* mapping = _mapper->getMapping();
+                inLats.emplace_back();
+                for(auto& elem : subDfgs[i]->inputs()){
+                    inLats.back()[subDfgs[i]->inputName(elem.first)] = mapping->dfgInputAttr(elem.first).lat;
+                }
+                outLats.emplace_back();
+                for(auto& elem : subDfgs[i]->outputs()){
+                    outLats.back()[subDfgs[i]->outputName(elem.first)] = mapping->dfgOutputAttr(elem.first).lat;
+                }
+            }
+        }
+        if(succeed){
+            schedule(dfg, inLats, outLats);
+            if(dumpConfig || dumpMappedViz){
+                dumpSchedule((resultDir.empty()? "results" : resultDir) + "/mapped_system.txt");
+            }
+            std::cout << "ADG instances: " << subDfgs.size() << ", system latency: " << _latency << std::endl;
+        }
+        for(auto subDfg : subDfgs){
+            delete subDfg;
+        }
+    }
+    _mapper->setTimeOut(timeout);
+    return succeed;
+}
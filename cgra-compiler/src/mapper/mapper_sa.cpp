@@ -20,30 +20,452 @@ MapperSA::~MapperSA(){}
 
 // map the DFG to the ADG, mapper API
 bool MapperSA::mapper(){
+    // try the fast greedy constructive mapping first, fall back to SA
+    if(greedyMap()){
+        spdlog::warn("Greedy mapping succeeded, max latency: {}", _mapping->maxLat());
+        return true;
+    }
+    // small DFG: exact search, fail fast if proved no mapping
+    double timeout = getTimeOut();
+    if(getDFG()->nodes().size() <= _exactMaxNodes){
+        int res = exactMap();
+        if(res == 1){
+            spdlog::warn("Exact mapping succeeded, max latency: {}", _mapping->maxLat());
+            return true;
+        } else if(res == 0){
+            spdlog::warn("Exact mapping proved no placement satisfying the routing-independent constraints");
+            return false;
+        } else if(res == -2){ // exhausted without proof, SA only tries for a short time
+            spdlog::warn("Exact mapping exhausted, try SA for at most {} ms", EXACT_SA_TIMEOUT);
+            setTimeOut(std::min(timeout, runningTimeMS() + EXACT_SA_TIMEOUT));
+        }
+    }
     bool succeed;
     if(_objOpt){ // objective optimization
         succeed = pnrSyncOpt();
     }else{
         succeed = pnrSync(_maxIters, MAX_TEMP, true);
     }
+    setTimeOut(timeout);
+    return succeed;
+}
+
+
+// deterministic greedy constructive mapping
+// place the DFG nodes in topological, criticality-weighted order, then schedule the latency in a single pass
+// return false if failed or the max latency exceeds the critical path latency by GREEDY_LAT_SLACK
+bool MapperSA::greedyMap(){
+    ADG* adg = _mapping->getADG();
+    DFG* dfg = _mapping->getDFG();
+    // ASAP latency and height (latency to the DFG output) of the DFG nodes, ignoring the routing latency
+    std::map<int, int> asap, height;
+    int critLat = 0; // critical path latency
+    for(auto node : dfg->topoNodes()){
+        int lat = 0;
+        for(auto& elem : node->inputs()){
+            int inNodeId = elem.second.first;
+            if(inNodeId != dfg->id() && !dfg->edge(node->inputEdge(elem.first))->isBackEdge()){
+                lat = std::max(lat, asap[inNodeId] + dfg->node(inNodeId)->opLatency());
+            }
+        }
+        asap[node->id()] = lat;
+        critLat = std::max(critLat, lat + node->opLatency());
+    }
+    auto& topoNodes = dfg->topoNodes();
+    for(auto iter = topoNodes.rbegin(); iter != topoNodes.rend(); iter++){
+        auto node = *iter;
+        int lat = 0;
+        for(auto& elem : node->outputEdges()){
+            for(int eid : elem.second){
+                DFGEdge* edge = dfg->edge(eid);
+                if(edge->dstId() != dfg->id() && !edge->isBackEdge()){
+                    lat = std::max(lat, height[edge->dstId()]);
+                }
+            }
+        }
+        height[node->id()] = lat + node->opLatency();
+    }
+    // topological order, the critical nodes (large height) first in the same level
+    std::vector<int> order;
+    for(auto node : topoNodes){
+        order.push_back(node->id());
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b){
+        if(asap[a] != asap[b]){
+            return asap[a] < asap[b];
+        }
+        return height[a] > height[b];
+    });
+    Mapping* mapping = new Mapping(adg, dfg, getRouteTemplates(), getII());
+    std::map<int, int> readyLat; // latency of the placed DFG node outputs, not considering the delay pipes
+    // latency cost of the placed DFG node: output latency and the operand misalignment beyond the max delay
+    auto latCost = [&](DFGNode* dfgNode, ADGNode* adgNode, int& lat){
+        int maxLat = 0;
+        int minLat = INT_MAX;
+        for(auto& elem : dfgNode->inputEdges()){
+            int eid = elem.second;
+            if(dfg->edge(eid)->isBackEdge()){ // the loop-carried value is aligned by the II
+                continue;
+            }
+            mapping->calEdgeRouteLat(eid);
+            int srcId = dfg->edge(eid)->srcId();
+            int inLat = ((srcId == dfg->id())? 0 : readyLat[srcId]) + mapping->dfgEdgeAttr(eid).latNoDelay;
+            maxLat = std::max(maxLat, inLat);
+            minLat = std::min(minLat, inLat);
+        }
+        lat = maxLat + dfgNode->opLatency();
+        int vio = (minLat == INT_MAX)? 0 : std::max(0, maxLat - minLat - dynamic_cast<GPENode*>(adgNode)->maxDelay());
+        return lat + 2 * vio;
+    };
+    bool succeed = true;
+    for(int id : order){
+        auto dfgNode = dfg->node(id);
+        std::vector<ADGNode*> candidates;
+        if(isLargeAdg()){
+            candidates = findCandidatesInTiles(mapping, dfgNode, 50);
+        } else{
+            for(auto& elem : adg->nodes()){
+                auto adgNode = elem.second;
+                if(isCapable(dfgNode, adgNode) && !mapping->isMapped(adgNode)){
+                    candidates.push_back(adgNode);
+                }
+            }
+        }
+        std::vector<int> sortedIdx = sortCandidates(mapping, dfgNode, candidates);
+        std::vector<ADGNode*> sortedCandidates;
+        for(int idx : sortedIdx){
+            sortedCandidates.push_back(candidates[idx]);
+        }
+        // look ahead the nearest candidates, select the one with the min latency cost
+        ADGNode* bestCandidate = nullptr;
+        int minCost = INT_MAX;
+        int lat;
+        for(int i = 0; i < std::min((int)sortedCandidates.size(), GREEDY_LOOKAHEAD); i++){
+            auto candidate = sortedCandidates[i];
+            if(!mapping->estRoutable(dfgNode, candidate, ROUTE_EST_DEPTH) || !tryCandidate(mapping, dfgNode, candidate)){
+                continue;
+            }
+            int cost = latCost(dfgNode, candidate, lat);
+            if(cost < minCost){
+                minCost = cost;
+                bestCandidate = candidate;
+            }
+            mapping->unmapDfgNode(dfgNode);
+        }
+        if(bestCandidate){
+            tryCandidate(mapping, dfgNode, bestCandidate);
+        } else{
+            sortedCandidates.erase(sortedCandidates.begin(), sortedCandidates.begin() + std::min((int)sortedCandidates.size(), GREEDY_LOOKAHEAD));
+            if(sortedCandidates.empty() || tryCandidates(mapping, dfgNode, sortedCandidates) == -1){
+                spdlog::debug("Greedy mapping cannot map DFG node {0} : {1}", dfgNode->id(), dfgNode->name());
+                succeed = false;
+                break;
+            }
+        }
+        latCost(dfgNode, mapping->mappedNode(dfgNode), lat);
+        readyLat[id] = lat;
+    }
+    if(succeed){
+        mapping->latencySchedule();
+        if(mapping->totalViolation() > 0 && mapping->padLatency() > 0){ // absorb the violations by the detours
+            mapping->latencySchedule();
+        }
+        succeed = (mapping->totalViolation() == 0);
+    }
+    if(succeed && _objOpt && mapping->maxLat() > critLat + GREEDY_LAT_SLACK){
+        spdlog::debug("Greedy mapping max latency {0} exceeds the critical path latency {1}", mapping->maxLat(), critLat);
+        succeed = false;
+    }
+    if(succeed){
+        *_mapping = *mapping;
+    }
+    delete mapping;
     return succeed;
 }
 
 
+// exact backtracking mapping for small DFGs
+// the relaxed search only with the routing-independent constraints is a relaxation of the mapping problem,
+// its exhaustion proves no mapping exists; the exhausted exact search is not a proof, 
+// each edge is routed only once and the pass-through nodes may fix the violations
+// return 1 : success; 0 : proved no mapping by the routing-independent constraints;
+// -1 : unknown, budget exhausted; -2 : unknown, the search is exhausted
+int MapperSA::exactMap(){
+    ADG* adg = _mapping->getADG();
+    DFG* dfg = _mapping->getDFG();
+    Mapping* mapping = new Mapping(adg, dfg, getRouteTemplates(), getII());
+    int budget = EXACT_MAX_TRIES;
+    std::map<std::pair<int, int>, bool> nogoods; // routing-independent nogoods
+    int res;
+    if(!matchable(mapping)){ // not enough capable GPE nodes for all the DFG nodes together
+        res = 0;
+    } else{
+        std::map<int, int> placement;
+        std::set<int> usedGpes;
+        res = relaxedSearch(0, placement, usedGpes, budget, nogoods);
+        if(res == 1){
+            budget = EXACT_MAX_TRIES;
+            res = exactSearch(mapping, 0, budget, nogoods);
+            if(res == 0){ // exhausted, not a proof
+                res = -2;
+            }
+        }
+    }
+    if(res == 1){
+        *_mapping = *mapping;
+    }
+    spdlog::debug("Exact mapping result {0}, tries {1}, nogoods {2}", res, EXACT_MAX_TRIES - budget, nogoods.size());
+    delete mapping;
+    return res;
+}
+
+
+// if the unmapped DFG nodes can be matched to the free capable GPE nodes, bipartite matching
+bool MapperSA::matchable(Mapping* mapping){
+    DFG* dfg = mapping->getDFG();
+    std::vector<std::vector<int>> domains; // free capable GPE node IDs of each unmapped DFG node
+    for(auto& elem : dfg->nodes()){
+        auto dfgNode = elem.second;
+        if(mapping->isMapped(dfgNode)){
+            continue;
+        }
+        std::vector<int> domain;
+        for(auto& gpeElem : mapping->getADG()->nodes()){
+            auto adgNode = gpeElem.second;
+            if(isCapable(dfgNode, adgNode) && !mapping->isMapped(adgNode)){
+                domain.push_back(gpeElem.first);
+            }
+        }
+        domains.push_back(domain);
+    }
+    std::map<int, int> matchedNode; // <gpe-id, index of the matched DFG node>
+    // find augmenting path from the DFG node
+    std::function<bool(int, std::set<int>&)> augment = [&](int idx, std::set<int>& visited){
+        for(int gpeId : domains[idx]){
+            if(visited.count(gpeId)){
+                continue;
+            }
+            visited.emplace(gpeId);
+            if(!matchedNode.count(gpeId) || augment(matchedNode[gpeId], visited)){
+                matchedNode[gpeId] = idx;
+                return true;
+            }
+        }
+        return false;
+    };
+    for(int i = 0; i < domains.size(); i++){
+        std::set<int> visited;
+        if(!augment(i, visited)){
+            return false;
+        }
+    }
+    return true;
+}
+
+
+// forward checking: each unmapped neighbor of the DFG node keeps at least one free capable GPE node
+// passing the routability estimation
+bool MapperSA::forwardCheck(Mapping* mapping, DFGNode* dfgNode){
+    DFG* dfg = mapping->getDFG();
+    std::set<int> nbIds;
+    for(auto& elem : dfgNode->inputs()){
+        nbIds.emplace(elem.second.first);
+    }
+    for(auto& elem : dfgNode->outputs()){
+        for(auto& outNode : elem.second){
+            nbIds.emplace(outNode.first);
+        }
+    }
+    for(int nbId : nbIds){
+        if(nbId == dfg->id()){
+            continue;
+        }
+        DFGNode* nbNode = dfg->node(nbId);
+        if(mapping->isMapped(nbNode)){
+            continue;
+        }
+        bool hasValue = false;
+        for(auto& elem : mapping->getADG()->nodes()){
+            auto adgNode = elem.second;
+            if(isCapable(nbNode, adgNode) && !mapping->isMapped(adgNode) &&
+               mapping->estRoutable(nbNode, adgNode, ROUTE_EST_DEPTH)){
+                hasValue = true;
+                break;
+            }
+        }
+        if(!hasValue){
+            return false;
+        }
+    }
+    return matchable(mapping);
+}
+
+
+// routing-independent nogood: the DFG node cannot be placed on the GPE node under any routing state,
+// i.e. some IO edge cannot reach the ADG IO, or some neighbor has no capable GPE node reachable from/to it
+// nogoods: cached results, <<dfgnode-id, gpenode-id>, is-nogood>
+bool MapperSA::isStaticNogood(DFGNode* dfgNode, ADGNode* gpeNode, std::map<std::pair<int, int>, bool>& nogoods){
+    auto key = std::make_pair(dfgNode->id(), gpeNode->id());
+    auto iter = nogoods.find(key);
+    if(iter != nogoods.end()){
+        return iter->second;
+    }
+    const int inf = 0x7fffffff;
+    ADG* adg = getADG();
+    DFG* dfg = getDFG();
+    // reachable from any IB node (toGpe) or to any OB node
+    auto ioReachable = [&](bool toGpe){
+        for(auto& elem : adg->nodes()){
+            if(elem.second->type() != (toGpe? "IB" : "OB")){
+                continue;
+            }
+            int dist = toGpe? getAdgNodeDist(elem.first, gpeNode->id()) : getAdgNodeDist(gpeNode->id(), elem.first);
+            if(dist < inf){
+                return true;
+            }
+        }
+        return false;
+    };
+    // the neighbor has a capable GPE node reachable from/to this GPE node
+    auto nbReachable = [&](DFGNode* nbNode, bool toGpe){
+        for(auto& elem : adg->nodes()){
+            if(elem.second == gpeNode || !isCapable(nbNode, elem.second)){
+                continue;
+            }
+            int dist = toGpe? getAdgNodeDist(elem.first, gpeNode->id()) : getAdgNodeDist(gpeNode->id(), elem.first);
+            if(dist < inf){
+                return true;
+            }
+        }
+        return false;
+    };
+    bool nogood = false;
+    for(auto& elem : dfgNode->inputs()){
+        int srcId = elem.second.first;
+        if(srcId == dfgNode->id()){ // self-loop
+            continue;
+        }
+        nogood = (srcId == dfg->id())? !ioReachable(true) : !nbReachable(dfg->node(srcId), true);
+        if(nogood){
+            break;
+        }
+    }
+    for(auto& elem : dfgNode->outputs()){
+        for(auto& outNode : elem.second){
+            if(nogood || outNode.first == dfgNode->id()){
+                continue;
+            }
+            nogood = (outNode.first == dfg->id())? !ioReachable(false) : !nbReachable(dfg->node(outNode.first), false);
+        }
+    }
+    nogoods[key] = nogood;
+    return nogood;
+}
+
+
+// relaxed placement search only with the routing-independent constraints: capability, one DFG node per GPE node,
+// the nogoods and the reachability between the GPE nodes of each DFG edge
+// placement: <dfgnode-id, gpenode-id>; usedGpes: GPE nodes in the placement
+// return 1 : placeable; 0 : exhausted, no mapping exists; -1 : budget exhausted
+int MapperSA::relaxedSearch(int depth, std::map<int, int>& placement, std::set<int>& usedGpes, int& budget, 
+                            std::map<std::pair<int, int>, bool>& nogoods){
+    if(depth == dfgNodeIdPlaceOrder.size()){
+        return 1;
+    }
+    const int inf = 0x7fffffff;
+    DFG* dfg = getDFG();
+    DFGNode* dfgNode = dfg->node(dfgNodeIdPlaceOrder[depth]);
+    for(auto& elem : getADG()->nodes()){
+        auto adgNode = elem.second;
+        if(!isCapable(dfgNode, adgNode) || usedGpes.count(adgNode->id()) || isStaticNogood(dfgNode, adgNode, nogoods)){
+            continue;
+        }
+        if(--budget < 0 || runningTimeMS() > getTimeOut()){
+            return -1;
+        }
+        bool reachable = true;
+        for(auto& in : dfgNode->inputs()){
+            auto iter = placement.find(in.second.first);
+            reachable &= (iter == placement.end()) || getAdgNodeDist(iter->second, adgNode->id()) < inf;
+        }
+        for(auto& out : dfgNode->outputs()){
+            for(auto& outNode : out.second){
+                auto iter = placement.find(outNode.first);
+                reachable &= (iter == placement.end()) || getAdgNodeDist(adgNode->id(), iter->second) < inf;
+            }
+        }
+        if(!reachable){
+            continue;
+        }
+        placement[dfgNode->id()] = adgNode->id();
+        usedGpes.emplace(adgNode->id());
+        int res = relaxedSearch(depth + 1, placement, usedGpes, budget, nogoods);
+        if(res != 0){ // placeable or budget exhausted
+            return res;
+        }
+        placement.erase(dfgNode->id());
+        usedGpes.erase(adgNode->id());
+    }
+    return 0;
+}
+
+
+// backtracking search placing the DFG nodes in dfgNodeIdPlaceOrder from the depth-th one
+// each edge is routed once by tryCandidate, the other routes are not searched
+// return 1 : success; 0 : exhausted; -1 : budget exhausted
+int MapperSA::exactSearch(Mapping* mapping, int depth, int& budget, std::map<std::pair<int, int>, bool>& nogoods){
+    if(depth == dfgNodeIdPlaceOrder.size()){
+        mapping->latencySchedule();
+        if(mapping->totalViolation() > 0 && mapping->padLatency() > 0){ // absorb the violations by the detours
+            mapping->latencySchedule();
+        }
+        if(mapping->totalViolation() == 0){
+            return 1;
+        }
+        return 0;
+    }
+    DFG* dfg = mapping->getDFG();
+    DFGNode* dfgNode = dfg->node(dfgNodeIdPlaceOrder[depth]);
+    std::vector<ADGNode*> candidates;
+    for(auto& elem : mapping->getADG()->nodes()){
+        auto adgNode = elem.second;
+        if(isCapable(dfgNode, adgNode) && !mapping->isMapped(adgNode) && !isStaticNogood(dfgNode, adgNode, nogoods)){
+            candidates.push_back(adgNode);
+        }
+    }
+    std::vector<int> sortedIdx = sortCandidates(mapping, dfgNode, candidates);
+    for(int idx : sortedIdx){
+        if(--budget < 0 || runningTimeMS() > getTimeOut()){
+            return -1;
+        }
+        auto candidate = candidates[idx];
+        if(!mapping->estRoutable(dfgNode, candidate, ROUTE_EST_DEPTH) || !tryCandidate(mapping, dfgNode, candidate)){
+            continue;
+        }
+        int res = forwardCheck(mapping, dfgNode)? exactSearch(mapping, depth + 1, budget, nogoods) : 0;
+        if(res != 0){ // success or budget exhausted
+            return res;
+        }
+        mapping->unmapDfgNode(dfgNode);
+    }
+    return 0;
+}
+
+
 // PnR, Data Synchronization, and objective optimization
 bool MapperSA::pnrSyncOpt(){
     int temp = MAX_TEMP; // temperature
     int maxItersMapSched = 500; // pnrSync iteration number
-    int maxItersNoImprv = 50;  // if not improved for maxItersNoImprv, end
-    int restartIters = 20;     // if not improved for restartIters, restart from the cached status
+    int maxItersNoImprv = 50;  // if not improved for maxItersNoImprv, end anyway
     int lastImprvIter = 0;
-    int lastRestartIter = 0;
     int newObj;
     int oldObj = 0x7fffffff;
     int minObj = 0x7fffffff;
     bool succeed = false;
-    Mapping* bestMapping = new Mapping(getADG(), getDFG());
-    Mapping* lastAcceptMapping = new Mapping(getADG(), getDFG());
+    double acceptRate = 1.0; // accept rate of the new solutions
+    CostStats objStats; // statistics of the objective since the last improvement
+    Mapping* bestMapping = new Mapping(getADG(), getDFG(), getRouteTemplates(), getII());
+    Mapping* lastAcceptMapping = new Mapping(getADG(), getDFG(), getRouteTemplates(), getII());
     for(int iter = 0; iter < _maxIters; iter++){
         if(runningTimeMS() > getTimeOut()){
             break;
@@ -61,14 +483,16 @@ bool MapperSA::pnrSyncOpt(){
         // Objective function
         newObj = objFunc(_mapping);
         spdlog::debug("Object: {}", newObj);
+        objStats.add(newObj);
         int difObj = newObj - oldObj;
-        if(metropolis(difObj, temp)){ // accept new solution according to the Metropolis rule
+        bool accept = metropolis(difObj, temp); // accept new solution according to the Metropolis rule
+        acceptRate = (1 - ACCEPT_RATE_WEIGHT) * acceptRate + ACCEPT_RATE_WEIGHT * accept;
+        if(accept){
             if(newObj < minObj){ // get better result
                 minObj = newObj;
                 *bestMapping = *_mapping; // cache better mapping status, ##### DEFAULT "=" IS OK #####
                 lastImprvIter = iter; 
-                lastRestartIter = iter; 
-                temp = annealFunc(temp); //  annealling
+                objStats.reset();
                 spdlog::warn("###### Better object: {} ######", newObj);
             }
             *lastAcceptMapping = *_mapping; // can keep trying based on current status          
@@ -76,13 +500,23 @@ bool MapperSA::pnrSyncOpt(){
         }else{
             *_mapping = *lastAcceptMapping; // restart from the cached status 
         }
-        if(iter - lastImprvIter > maxItersNoImprv){ // if not improved for long time, STOP            
+        double progress = std::max((double)iter / _maxIters, runningTimeMS() / getTimeOut());
+        temp = annealFunc(temp, acceptRate, progress); //  annealling
+        int itersNoImprv = iter - lastImprvIter;
+        if(itersNoImprv > maxItersNoImprv){ // if not improved for long time, STOP            
             break;
         }
-        if(iter - lastRestartIter > restartIters){ // if not improved for some time, restart from the cached status 
-            *_mapping = *bestMapping;
-            lastRestartIter = iter;    
-        } 
+        if(objStats.num >= MIN_STATS_SAMPLES){ // enough samples of the objective, the failed PnRs are not sampled
+            double stdObj = objStats.stddev();
+            if(objStats.frozen(FROZEN_REL_STD)){ // frozen: new solutions keep the same objective, STOP
+                break;
+            }
+            if(oldObj > minObj + 2 * stdObj){ // wander too far from the best, restart from the cached status 
+                *_mapping = *bestMapping;
+                *lastAcceptMapping = *bestMapping;
+                oldObj = minObj;
+            }
+        }
     }
     *_mapping = *bestMapping;
     delete bestMapping; 
@@ -96,13 +530,12 @@ bool MapperSA::pnrSyncOpt(){
 
 
 // PnR and Data Synchronization
-// return -1 : preMapCheck failed; 0 : fail; 1 : success
+// return -1 : preMapCheck failed or only the late back edges violate; 0 : fail; 1 : success
 int MapperSA::pnrSync(int maxIters, int temp, bool modifyDfg){
-    int initTemp = temp;
     ADG* adg = _mapping->getADG();
     DFG* dfg = _mapping->getDFG();
-    Mapping* curMapping = new Mapping(adg, dfg);
-    Mapping* lastAcceptMapping = new Mapping(adg, dfg);
+    Mapping* curMapping = new Mapping(adg, dfg, getRouteTemplates(), getII());
+    Mapping* lastAcceptMapping = new Mapping(adg, dfg, getRouteTemplates(), getII());
     int numNodes = dfg->nodes().size();
     int maxItersNoImprv = 20 + numNodes/5; // if not improved for maxItersNoImprv, end
     // int restartIters = 20;     // if not improved for restartIters, restart from the cached status
@@ -113,6 +546,12 @@ int MapperSA::pnrSync(int maxIters, int temp, bool modifyDfg){
     int newVio;
     int oldVio = 0x7fffffff;
     int minVio = 0x7fffffff;
+    double acceptRate = 1.0; // accept rate of the new solutions
+    CostStats vioStats; // statistics of the violation since the last improvement
+    _keepMapping = false;
+    if(!_mapping->success()){ // no successful mapping yet, start from a global layout
+        globalPlace();
+    }
     for(int iter = 0; iter < maxIters; iter++){
         if(runningTimeMS() > getTimeOut()){
             break;
@@ -121,7 +560,15 @@ int MapperSA::pnrSync(int maxIters, int temp, bool modifyDfg){
         //     std::cout << ".";
         // }
         // PnR without latency scheduling of DFG nodes
+        bool kept = _keepMapping; // only place the pass-through nodes around the kept mapping
         int status = pnr(curMapping, temp);
+        _placeTargets.clear(); // only seed the first PnR, then leave the exploration to SA
+        if(status == -1 && kept){ // drop the kept mapping, restart from a global layout
+            delete curMapping;
+            curMapping = new Mapping(adg, getDFG(), getRouteTemplates(), getII());
+            *lastAcceptMapping = *curMapping;
+            globalPlace();
+        }
         if(status == -1){ // fail to map
             spdlog::debug("PnR failed once!");
             continue;
@@ -129,6 +576,9 @@ int MapperSA::pnrSync(int maxIters, int temp, bool modifyDfg){
         spdlog::info("PnR succeed, start data synchronization");
         // Data synchronization : schedule the latency of DFG nodes
         curMapping->latencySchedule();
+        if(curMapping->totalViolation() > 0 && curMapping->padLatency() > 0){ // absorb the violations by the detours
+            curMapping->latencySchedule();
+        }
         spdlog::info("Complete data synchronization, check latency violation");
         newVio = curMapping->totalViolation(); // latency violations
         if(newVio == 0){
@@ -136,14 +586,17 @@ int MapperSA::pnrSync(int maxIters, int temp, bool modifyDfg){
             *_mapping = *curMapping; // keep better mapping status, ##### DEFAULT "=" IS OK #####
             break;
         }
+        vioStats.add(newVio);
         int difVio = newVio - oldVio;
-        if(metropolis(difVio, temp)){ // accept new solution according to the Metropolis rule
+        bool accept = metropolis(difVio, temp); // accept new solution according to the Metropolis rule
+        acceptRate = (1 - ACCEPT_RATE_WEIGHT) * acceptRate + ACCEPT_RATE_WEIGHT * accept;
+        if(accept){
             if(newVio < minVio){ // get better result
                 minVio = newVio;
                 *_mapping = *curMapping; // cache better mapping status, ##### DEFAULT "=" IS OK #####
                 lastImprvIter = iter; 
                 // lastRestartIter = iter; 
-                temp = annealFunc(temp); //  annealling
+                vioStats.reset();
                 update = true;
                 spdlog::warn("#### Smaller violation: {} ####", minVio);
             }
@@ -152,22 +605,27 @@ int MapperSA::pnrSync(int maxIters, int temp, bool modifyDfg){
         }else{
             *curMapping = *lastAcceptMapping; 
         }
+        temp = annealFunc(temp, acceptRate, (double)iter / maxIters); //  annealling
+        int itersNoImprv = iter - lastImprvIter;
+        // frozen: the violation does not change any more, no need to wait for maxItersNoImprv
+        bool frozen = (vioStats.num >= MIN_STATS_SAMPLES) && vioStats.frozen(FROZEN_REL_STD);
         // if not improved for long time, insert pass-through nodes
-        if(iter - lastImprvIter > maxItersNoImprv){ 
+        if(itersNoImprv > maxItersNoImprv || frozen){ 
             if(!modifyDfg){ // cannot modify DFG, stop iteration
                 break;
             }                                  
             DFG* newDfg = new DFG();
-            int totalVio, maxVio;
-            if(update){
-                totalVio = _mapping->totalViolation();
-                maxVio = _mapping->maxViolation();
-                _mapping->insertPassDfgNodes(newDfg); // insert pass-through nodes into DFG
-            }else{
-                totalVio = lastAcceptMapping->totalViolation();
-                maxVio = lastAcceptMapping->maxViolation();
-                lastAcceptMapping->insertPassDfgNodes(newDfg); // insert pass-through nodes into DFG
-            }            
+            Mapping* vioMapping = update? _mapping : lastAcceptMapping; // the mapping to insert pass-through nodes
+            int totalVio = vioMapping->totalViolation();
+            int maxVio = vioMapping->maxViolation();
+            if(vioMapping->insertPassDfgNodes(newDfg) == 0){ // only the late back edges violate, need larger II
+                delete newDfg;
+                succeed = -1;
+                break;
+            }
+            // keep the current mapping, only the pass-through nodes and the split edges need placing and routing
+            *curMapping = *vioMapping;
+            curMapping->rebindDfg(newDfg);
             spdlog::warn("Min total latency violation: {}", minVio);
             spdlog::warn("Current total latency violation: {}", totalVio); 
             spdlog::warn("Current max latency violation: {}", maxVio);  
@@ -178,15 +636,16 @@ int MapperSA::pnrSync(int maxIters, int temp, bool modifyDfg){
                 succeed = -1;
                 break;
             }
-            delete curMapping; 
-            curMapping = new Mapping(adg, newDfg);
             *lastAcceptMapping = *curMapping;
+            _keepMapping = true;
             lastImprvIter = iter; 
             // lastRestartIter = iter; 
-            temp = initTemp;
+            // keep the annealed temperature, restarting hot would scatter the kept mapping
             oldVio = 0x7fffffff;
             minVio = 0x7fffffff;
             update = false;
+            acceptRate = 1.0;
+            vioStats.reset();
             int numNodesNew = _mapping->getDFG()->nodes().size();
             maxItersNoImprv = 20 + numNodesNew/5 + numNodesNew - numNodes;
             spdlog::warn("DFG node number: {}", numNodesNew);
@@ -209,11 +668,88 @@ int MapperSA::pnrSync(int maxIters, int temp, bool modifyDfg){
 
 // PnR with SA temperature(max = 100)
 int MapperSA::pnr(Mapping* mapping, int temp){
-    unmapSome(mapping, temp);
+    if(_keepMapping){ // the first PnR after inserting the pass-through nodes, no random moves
+        _keepMapping = false;
+        return incrPnR(mapping);
+    }
+    // complete mapping: half of the moves are the small swap/shift moves within the range limit
+    bool moved = mapping->success() && (rand()%2 == 0) && swapShiftMove(mapping, temp);
+    if(!moved){
+        // spend most of the moves on the broken part of the mapping, keep some random moves to escape
+        if((rand()%4 == 0) || !ripUpSome(mapping)){
+            unmapSome(mapping, temp);
+        }
+    }
     return incrPnR(mapping);
 }
 
 
+// range limit of the swap/shift moves, shrinking with the temperature
+int MapperSA::rangeLimit(int temp){
+    if(_maxRange == 0){ // the span of the GPE array
+        int minX = INT_MAX, maxX = 0, minY = INT_MAX, maxY = 0;
+        for(auto& elem : getADG()->nodes()){
+            auto node = elem.second;
+            if(node->type() == "GPE"){
+                minX = std::min(minX, node->x());
+                maxX = std::max(maxX, node->x());
+                minY = std::min(minY, node->y());
+                maxY = std::max(maxY, node->y());
+            }
+        }
+        _maxRange = std::max(1, std::max(maxX - minX, maxY - minY));
+    }
+    return std::max(1, (int)std::ceil((double)_maxRange * temp / MAX_TEMP));
+}
+
+
+// swap/shift move: move one mapped DFG node to a GPE node within the range limit around its current location
+// swap the two DFG nodes if the GPE node is occupied by another DFG node
+// only the edges of the moved DFG nodes are rerouted, the left unmapped nodes are placed by incrPnR
+// return false if no GPE node to move to
+bool MapperSA::swapShiftMove(Mapping* mapping, int temp){
+    DFG* dfg = mapping->getDFG();
+    auto& nodes = dfg->nodes();
+    auto iter = nodes.begin();
+    std::advance(iter, rand()%nodes.size());
+    DFGNode* dfgNode = iter->second;
+    ADGNode* srcAdgNode = mapping->mappedNode(dfgNode);
+    int range = rangeLimit(temp);
+    // GPE nodes within the range limit
+    std::vector<ADGNode*> targets;
+    for(auto& elem : getADG()->nodes()){
+        auto adgNode = elem.second;
+        if(adgNode->type() != "GPE" || adgNode == srcAdgNode ||
+           std::abs(adgNode->x() - srcAdgNode->x()) > range || std::abs(adgNode->y() - srcAdgNode->y()) > range){
+            continue;
+        }
+        if(!isCapable(dfgNode, adgNode)){
+            continue;
+        }
+        DFGNode* swapNode = mapping->mappedNode(adgNode);
+        if(swapNode && !isCapable(swapNode, srcAdgNode)){
+            continue;
+        }
+        targets.push_back(adgNode);
+    }
+    if(targets.empty()){
+        return false;
+    }
+    ADGNode* dstAdgNode = targets[rand()%targets.size()];
+    DFGNode* swapNode = mapping->mappedNode(dstAdgNode);
+    mapping->unmapDfgNode(dfgNode);
+    if(swapNode){ // swap move
+        mapping->unmapDfgNode(swapNode);
+        if(tryCandidate(mapping, dfgNode, dstAdgNode)){
+            tryCandidate(mapping, swapNode, srcAdgNode);
+        }
+    } else{ // shift move
+        tryCandidate(mapping, dfgNode, dstAdgNode);
+    }
+    return true;
+}
+
+
 // unmap some DFG nodes
 void MapperSA::unmapSome(Mapping* mapping, int temp){
     for(auto& elem : mapping->getDFG()->nodes()){
@@ -225,6 +761,79 @@ void MapperSA::unmapSome(Mapping* mapping, int temp){
 }
 
 
+// rip up the broken part of the mapping and unmap the related DFG nodes
+// if the last incremental PnR failed: the mapped neighbors of the failed DFG node and
+// the end nodes of the DFG edges passing through the GIBs around these neighbors
+// otherwise: the end nodes of the DFG edges with latency violation
+// return false if nothing is broken
+bool MapperSA::ripUpSome(Mapping* mapping){
+    DFG* dfg = mapping->getDFG();
+    std::set<int> ripNodeIds; // DFG nodes to be unmapped
+    DFGNode* failedNode = (_failedDfgNodeId >= 0)? dfg->node(_failedDfgNodeId) : nullptr;
+    if(failedNode && !mapping->isMapped(failedNode)){
+        std::set<int> neighborIds;
+        for(auto& elem : failedNode->inputs()){
+            neighborIds.emplace(elem.second.first);
+        }
+        for(auto& elem : failedNode->outputs()){
+            for(auto& outNode : elem.second){
+                neighborIds.emplace(outNode.first);
+            }
+        }
+        for(int id : neighborIds){
+            if(id == dfg->id()){ // connected to DFG IO
+                continue;
+            }
+            ADGNode* adgNode = mapping->mappedNode(dfg->node(id));
+            if(adgNode == nullptr){
+                continue;
+            }
+            ripNodeIds.emplace(id);
+            // the DFG edges passing through the GIBs around this neighbor block the failed node
+            std::set<int> gibIds;
+            for(auto& elem : adgNode->inputs()){
+                gibIds.emplace(elem.second.first);
+            }
+            for(auto& elem : adgNode->outputs()){
+                for(auto& outNode : elem.second){
+                    gibIds.emplace(outNode.first);
+                }
+            }
+            for(int gibId : gibIds){
+                for(auto& passAttr : mapping->adgNodeAttr(gibId).dfgEdgePass){
+                    ripNodeIds.emplace(passAttr.edge->srcId());
+                    ripNodeIds.emplace(passAttr.edge->dstId());
+                }
+            }
+        }
+    } else{
+        for(int eid : mapping->vioDfgEdges()){
+            DFGEdge* edge = dfg->edge(eid);
+            ripNodeIds.emplace(edge->srcId());
+            ripNodeIds.emplace(edge->dstId());
+        }
+    }
+    ripNodeIds.erase(dfg->id());
+    bool ripped = false;
+    for(int id : ripNodeIds){
+        DFGNode* node = dfg->node(id);
+        if(node && mapping->isMapped(node)){
+            mapping->unmapDfgNode(node);
+            ripped = true;
+        }
+    }
+    return ripped;
+}
+
+
+// calculate the global placement of the DFG nodes to seed the first incremental PnR
+void MapperSA::globalPlace(){
+    GlobalPlacer placer(getADG(), gpeTiles());
+    _placeTargets = placer.place(getDFG(), dfgNodeIdPlaceOrder);
+    spdlog::debug("Global placement of {} DFG nodes", _placeTargets.size());
+}
+
+
 // incremental PnR, try to map all the left DFG nodes based on current mapping status
 int MapperSA::incrPnR(Mapping* mapping){
     auto dfg = mapping->getDFG();
@@ -246,6 +855,7 @@ int MapperSA::incrPnR(Mapping* mapping){
     // std::cout << std::endl;
     // start mapping
     bool succeed = true;
+    _failedDfgNodeId = -1;
     // Candidate cdt(mapping, 50);
     // Candidate cdt(mapping, getADG()->numGpeNodes());
     for(int id : dfgNodeIdPlaceOrder){        
@@ -264,6 +874,7 @@ int MapperSA::incrPnR(Mapping* mapping){
                 // }
                 // Graphviz viz(mapping, "results");
                 // viz.printDFGEdgePath();
+                _failedDfgNodeId = id;
                 succeed = false;
                 break;
             }
@@ -282,7 +893,8 @@ int MapperSA::tryCandidates(Mapping* mapping, DFGNode* dfgNode, const std::vecto
     // std::vector<int> sortedIdx = sortCandidates(mapping, dfgNode, candidates);
     int idx = 0;
     for(auto& candidate : candidates){
-        if(tryCandidate(mapping, dfgNode, candidate)){            
+        // only route the candidates passing the cheap routability estimation
+        if(mapping->estRoutable(dfgNode, candidate, ROUTE_EST_DEPTH) && tryCandidate(mapping, dfgNode, candidate)){            
             return idx;
         }
         idx++;
@@ -293,19 +905,23 @@ int MapperSA::tryCandidates(Mapping* mapping, DFGNode* dfgNode, const std::vecto
 // find candidates for one DFG node based on current mapping status
 std::vector<ADGNode*> MapperSA::findCandidates(Mapping* mapping, DFGNode* dfgNode, int maxCandidates){
     std::vector<ADGNode*> candidates;
-    for(auto& elem : mapping->getADG()->nodes()){
-        auto adgNode = elem.second;
-        //select GPE node
-        if(adgNode->type() != "GPE"){  
-            continue;
-        }
-        GPENode* gpeNode = dynamic_cast<GPENode*>(adgNode);
-        // check if the DFG node operationis supported
-        if(!gpeNode->opCapable(dfgNode->operation())){
-            continue;
-        }
-        if(!mapping->isMapped(gpeNode)){
-            candidates.push_back(gpeNode);
+    if(isLargeAdg()){ // only search the tiles around the mapped neighbors
+        candidates = findCandidatesInTiles(mapping, dfgNode, maxCandidates);
+    } else{
+        for(auto& elem : mapping->getADG()->nodes()){
+            auto adgNode = elem.second;
+            //select GPE node
+            if(adgNode->type() != "GPE"){  
+                continue;
+            }
+            GPENode* gpeNode = dynamic_cast<GPENode*>(adgNode);
+            // check if the DFG node operationis supported
+            if(!isCapable(dfgNode, gpeNode)){
+                continue;
+            }
+            if(!mapping->isMapped(gpeNode)){
+                candidates.push_back(gpeNode);
+            }
         }
     }
     // randomly select candidates
@@ -318,10 +934,83 @@ std::vector<ADGNode*> MapperSA::findCandidates(Mapping* mapping, DFGNode* dfgNod
     for(int i = 0; i < num; i++){
         sortedCandidates.push_back(candidates[sortedIdx[i]]);
     }
+    // try the globally placed GPE node first
+    auto iter = _placeTargets.find(dfgNode->id());
+    if(iter != _placeTargets.end()){
+        ADGNode* target = mapping->getADG()->node(iter->second);
+        if(!mapping->isMapped(target)){
+            auto pos = std::find(sortedCandidates.begin(), sortedCandidates.end(), target);
+            if(pos != sortedCandidates.end()){
+                sortedCandidates.erase(pos);
+            }
+            sortedCandidates.insert(sortedCandidates.begin(), target);
+        }
+    }
     return sortedCandidates;
 }
 
 
+// find candidates in the tiles around the mapped neighbors of the DFG node, ring by ring
+// stop when maxCandidates candidates are found
+std::vector<ADGNode*> MapperSA::findCandidatesInTiles(Mapping* mapping, DFGNode* dfgNode, int maxCandidates){
+    DFG* dfg = mapping->getDFG();
+    // center tile: the average tile of the mapped neighbors, or the globally placed tile, or a random tile
+    double sumCol = 0, sumRow = 0;
+    int num = 0;
+    std::vector<int> nbIds; // neighbor DFG node IDs
+    for(auto& elem : dfgNode->inputs()){
+        nbIds.push_back(elem.second.first);
+    }
+    for(auto& elem : dfgNode->outputs()){
+        for(auto& outNode : elem.second){
+            nbIds.push_back(outNode.first);
+        }
+    }
+    for(int nbId : nbIds){
+        if(nbId == dfg->id()){ // connected to DFG IO
+            continue;
+        }
+        ADGNode* adgNode = mapping->mappedNode(dfg->node(nbId));
+        if(adgNode){
+            auto tile = gpeNodeTile(adgNode->id());
+            sumCol += tile.first;
+            sumRow += tile.second;
+            num++;
+        }
+    }
+    auto& tiles = gpeTiles();
+    std::pair<int, int> center;
+    if(num > 0){
+        center = std::make_pair((int)std::round(sumCol / num), (int)std::round(sumRow / num));
+    } else if(_placeTargets.count(dfgNode->id())){
+        center = gpeNodeTile(_placeTargets[dfgNode->id()]);
+    } else{
+        auto iter = tiles.begin();
+        std::advance(iter, rand() % tiles.size());
+        center = iter->first;
+    }
+    std::vector<ADGNode*> candidates;
+    int maxRing = 0;
+    for(auto& elem : tiles){
+        maxRing = std::max(maxRing, std::max(std::abs(elem.first.first - center.first), std::abs(elem.first.second - center.second)));
+    }
+    for(int ring = 0; ring <= maxRing && candidates.size() < maxCandidates; ring++){
+        for(auto& elem : tiles){
+            if(std::max(std::abs(elem.first.first - center.first), std::abs(elem.first.second - center.second)) != ring){
+                continue;
+            }
+            for(int id : elem.second){
+                GPENode* gpeNode = dynamic_cast<GPENode*>(mapping->getADG()->node(id));
+                if(isCapable(dfgNode, gpeNode) && !mapping->isMapped(gpeNode)){
+                    candidates.push_back(gpeNode);
+                }
+            }
+        }
+    }
+    return candidates;
+}
+
+
 // get the shortest distance between ADG node and the available ADG input
 int MapperSA::getAdgNode2InputDist(Mapping* mapping, int id){
     // shortest distance between ADG node (GPE node) and the ADG IO
@@ -345,40 +1034,75 @@ int MapperSA::getAdgNode2OutputDist(Mapping* mapping, int id){
     return minDist;
 }
 
+// get the congestion of the GIB nodes around the ADG node
+// return the percentage of the used GIB output ports
+int MapperSA::getAdgNodeCongestion(Mapping* mapping, ADGNode* adgNode){
+    std::set<int> gibIds; // GIB nodes connected to the ADG node
+    for(auto& elem : adgNode->inputs()){
+        gibIds.emplace(elem.second.first);
+    }
+    for(auto& elem : adgNode->outputs()){
+        for(auto& outNode : elem.second){
+            gibIds.emplace(outNode.first);
+        }
+    }
+    int usedPorts = 0;
+    int totalPorts = 0;
+    for(int id : gibIds){
+        ADGNode* gibNode = getADG()->node(id);
+        if(gibNode == nullptr || gibNode->type() != "GIB"){
+            continue;
+        }
+        usedPorts += mapping->gibCongestion(id);
+        totalPorts += gibNode->numOutputs();
+    }
+    return (totalPorts > 0)? (usedPorts * 100 / totalPorts) : 0;
+}
+
 // sort candidates according to their distances with the mapped src and dst ADG nodes of this DFG node 
+// the distance of each edge is weighted by its criticality, keeping the critical edges short
 // return sorted index of candidates
 std::vector<int> MapperSA::sortCandidates(Mapping* mapping, DFGNode* dfgNode, const std::vector<ADGNode*>& candidates){
-    // mapped ADG node IDs of the source and destination node of this DFG node
-    std::vector<int> srcAdgNodeId, dstAdgNodeId; 
-    int num2in = 0;  // connected to DFG input port
-    int num2out = 0; // connected to DFG output port
+    // mapped ADG node IDs of the source and destination node of this DFG node, <adgnode-id, edge-weight>
+    std::vector<std::pair<int, int>> srcAdgNodeId, dstAdgNodeId; 
+    int num2in = 0;  // connected to DFG input port, weighted
+    int num2out = 0; // connected to DFG output port, weighted
+    int numEdges = 0; // the edges to be routed through the GIBs around the candidate, weighted
     DFG* dfg = mapping->getDFG();
-    for(auto& elem : dfgNode->inputs()){
-        int inNodeId = elem.second.first;
+    for(auto& elem : dfgNode->inputEdges()){
+        DFGEdge* edge = dfg->edge(elem.second);
+        int weight = edgeCritWeight(edge->id());
+        int inNodeId = edge->srcId();
         if(inNodeId == dfg->id()){ // connected to DFG input port
-            if(mapping->isDfgInputMapped(elem.second.second)){ // the DFG input port already mapped
-                auto ibId = getADG()->input(mapping->dfgInputAttr(elem.second.second).adgIOPort).begin()->first;
-                srcAdgNodeId.push_back(ibId);
+            if(mapping->isDfgInputMapped(edge->srcPortIdx())){ // the DFG input port already mapped
+                auto ibId = getADG()->input(mapping->dfgInputAttr(edge->srcPortIdx()).adgIOPort).begin()->first;
+                srcAdgNodeId.push_back(std::make_pair(ibId, weight));
             }else{
-                num2in++;
+                num2in += weight;
             }
+            numEdges += weight;
             continue;
         }
         auto inNode = dfg->node(inNodeId);
         auto adgNode = mapping->mappedNode(inNode);
         if(adgNode){
-            srcAdgNodeId.push_back(adgNode->id());
+            srcAdgNodeId.push_back(std::make_pair(adgNode->id(), weight));
+            numEdges += weight;
         }
     }
-    for(auto& elem : dfgNode->outputs()){
-        for(auto outNode : elem.second){
-            if(outNode.first == dfg->id()){ // connected to DFG output port
-                num2out++;
+    for(auto& elem : dfgNode->outputEdges()){
+        for(int eid : elem.second){
+            DFGEdge* edge = dfg->edge(eid);
+            int weight = edgeCritWeight(eid);
+            if(edge->dstId() == dfg->id()){ // connected to DFG output port
+                num2out += weight;
+                numEdges += weight;
                 continue;
             }
-            auto adgNode = mapping->mappedNode(dfg->node(outNode.first));
+            auto adgNode = mapping->mappedNode(dfg->node(edge->dstId()));
             if(adgNode){
-                dstAdgNodeId.push_back(adgNode->id());
+                dstAdgNodeId.push_back(std::make_pair(adgNode->id(), weight));
+                numEdges += weight;
             }
         }        
     }
@@ -387,14 +1111,16 @@ std::vector<int> MapperSA::sortCandidates(Mapping* mapping, DFGNode* dfgNode, co
     for(int i = 0; i < candidates.size(); i++){
         int sum = 0;
         int cdtId = candidates[i]->id();
-        for(auto id : srcAdgNodeId){
-            sum += getAdgNodeDist(id, cdtId);
+        for(auto& elem : srcAdgNodeId){
+            sum += elem.second * getAdgNodeDist(elem.first, cdtId);
         }
-        for(auto id : dstAdgNodeId){
-            sum += getAdgNodeDist(cdtId, id);
+        for(auto& elem : dstAdgNodeId){
+            sum += elem.second * getAdgNodeDist(cdtId, elem.first);
         }
         sum += num2in * getAdgNode2InputDist(mapping, cdtId);
         sum += num2out * getAdgNode2OutputDist(mapping, cdtId);
+        // congestion penalty, fully congested GIBs cost CONGEST_WEIGHT more hops per edge
+        sum += numEdges * CONGEST_WEIGHT * getAdgNodeCongestion(mapping, candidates[i]) / 100;
         sumDist.push_back(sum);
         sortedIdx.push_back(i);
     }
@@ -423,7 +1149,8 @@ bool MapperSA::tryCandidate(Mapping* mapping, DFGNode* dfgNode, ADGNode* candida
             }
         }
         DFGNode* inNode = dfg->node(edge->srcId());
-        ADGNode* adgNode = mapping->mappedNode(inNode);
+        // self-loop back edge: route from the candidate to itself
+        ADGNode* adgNode = (inNode == dfgNode)? candidate : mapping->mappedNode(inNode);
         if(adgNode){
             succeed = mapping->routeDfgEdge(edge, adgNode, candidate); // route edge between candidate and adgNode
             if(succeed){
@@ -497,8 +1224,25 @@ bool MapperSA::metropolis(double diff, double temp){
 }
 
 
-// annealing funtion
-int MapperSA::annealFunc(int temp){
+// target accept rate of the modified Lam schedule at the annealing progress (0~1)
+double MapperSA::lamTargetRate(double progress){
+    if(progress < 0.15){
+        return 0.44 + 0.56 * std::pow(560, -progress/0.15);
+    } else if(progress < 0.65){
+        return 0.44;
+    } else{
+        return 0.44 * std::pow(440, -(std::min(progress, 1.0) - 0.65)/0.35);
+    }
+}
+
+
+// adaptive annealing funtion
+// cool down if the accept rate is higher than the target accept rate, otherwise heat up
+int MapperSA::annealFunc(int temp, double acceptRate, double progress){
     float k = 0.9;
-    return int(k*temp);
+    if(acceptRate > lamTargetRate(progress)){
+        return std::max(1, int(k*temp));
+    } else{
+        return std::min(MAX_TEMP, std::max(temp + 1, int(temp/k)));
+    }
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 
 #include "mapper/mapping.h"
+#include "mapper/route_template.h"
 
 
 // reset mapping intermediate result and status
@@ -9,6 +10,13 @@ void Mapping::reset(){
     _dfgInputAttr.clear();
     _dfgOutputAttr.clear();
     _adgNodeAttr.clear();
+    _gibOutPortUsedCnt.clear();
+    _edgeLenCnt.clear();
+    _totalEdgeLen = 0;
+    _schedValid = false;
+    _schedDirtyEdges.clear();
+    _schedDirtyNodes.clear();
+    _critPathNodeIds.clear();
     // _adgLinkAttr.clear();
     _totalViolation = 0;
     _numNodeMapped = 0;
@@ -39,6 +47,26 @@ bool Mapping::isAdgNodeOutPortUsed(int nodeId, int portIdx){
 }
 
 
+// set the output port of the ADG node as used/unused and update the GIB congestion map
+void Mapping::setAdgNodeOutPortUsed(int nodeId, int portIdx, bool used){
+    auto& outPortUsed = _adgNodeAttr[nodeId].outPortUsed;
+    bool oldUsed = outPortUsed.count(portIdx) && outPortUsed[portIdx];
+    outPortUsed[portIdx] = used;
+    if(oldUsed != used && _adg->node(nodeId)->type() == "GIB"){
+        _gibOutPortUsedCnt[nodeId] += used? 1 : -1;
+    }
+}
+
+
+// number of the used output ports of the GIB node
+int Mapping::gibCongestion(int nodeId){
+    if(_gibOutPortUsedCnt.count(nodeId)){
+        return _gibOutPortUsedCnt[nodeId];
+    }
+    return 0;
+}
+
+
 // if the DFG node is already mapped
 bool Mapping::isMapped(DFGNode* dfgNode){
     if(_dfgNodeAttr.count(dfgNode->id())){
@@ -143,6 +171,7 @@ bool Mapping::mapDfgNode(DFGNode* dfgNode, ADGNode* adgNode){
         }
     }
 //     _adgNodeAttr[adgNode->id()] = adgAttr;
+    _schedDirtyNodes.emplace(dfgNode->id());
     _numNodeMapped++;
     return true;
 }
@@ -168,6 +197,7 @@ void Mapping::unmapDfgNode(DFGNode* dfgNode){
         _adgNodeAttr.erase(adgNode->id());
     }
     _dfgNodeAttr.erase(dfgNode->id());
+    _schedDirtyNodes.emplace(dfgNode->id());
     _numNodeMapped--;
 }
 
@@ -335,7 +365,7 @@ bool Mapping::routeDfgEdgePass(DFGEdge* edge, ADGNode* passNode, int srcPort, in
         edgePassAttr.srcPort = routeSrcPort;
         edgePassAttr.dstPort = routeDstPort;
         _adgNodeAttr[passNodeId].inPortUsed[routeSrcPort] = true;
-        _adgNodeAttr[passNodeId].outPortUsed[routeDstPort] = true;
+        setAdgNodeOutPortUsed(passNodeId, routeDstPort, true);
         _adgNodeAttr[passNodeId].dfgEdgePass.push_back(edgePassAttr);        
     }
     return true;
@@ -483,7 +513,7 @@ bool Mapping::routeDfgEdgeFromSrc(DFGEdge* edge, ADGNode* srcNode, ADGNode* dstN
             break; // get to the srcNode
         } else{ // intermediate routing nodes or OB
             nodeAttr.inPortUsed[srcPort] = true;
-            nodeAttr.outPortUsed[dstPort] = true;
+            setAdgNodeOutPortUsed(nodeId, dstPort, true);
             DfgEdgePassAttr passAttr;
             passAttr.edge = edge;
             passAttr.srcPort = srcPort;
@@ -495,6 +525,8 @@ bool Mapping::routeDfgEdgeFromSrc(DFGEdge* edge, ADGNode* srcNode, ADGNode* dstN
     }
     // reverse the passthrough nodes from srcNode to dstNode
     std::reverse(edgeLinks.begin(), edgeLinks.end());
+    updateEdgeLen(edgeLinks.size(), true);
+    _schedDirtyEdges.emplace(edge->id());
     // map DFG output port
     if(dstNode == nullptr){
         auto& attr = _dfgOutputAttr[edge->dstPortIdx()];
@@ -651,7 +683,7 @@ bool Mapping::routeDfgEdgeFromDst(DFGEdge* edge, ADGNode* srcNode, ADGNode* dstN
             break; // get to the dstNode
         } else{
             nodeAttr.inPortUsed[srcPort] = true;
-            nodeAttr.outPortUsed[dstPort] = true;
+            setAdgNodeOutPortUsed(nodeId, dstPort, true);
             DfgEdgePassAttr passAttr;
             passAttr.edge = edge;
             passAttr.srcPort = srcPort;
@@ -661,6 +693,8 @@ bool Mapping::routeDfgEdgeFromDst(DFGEdge* edge, ADGNode* srcNode, ADGNode* dstN
         srcPort = visitNodes[routeNode].dstInPortIdx;
         routeNode = std::make_pair(visitNodes[routeNode].dstNodeId, visitNodes[routeNode].dstOutPortIdx);
     }
+    updateEdgeLen(edgeLinks.size(), true);
+    _schedDirtyEdges.emplace(edge->id());
     // map DFG input port
     if(srcNode == nullptr){
         auto& attr = _dfgInputAttr[edge->srcPortIdx()];
@@ -671,6 +705,305 @@ bool Mapping::routeDfgEdgeFromDst(DFGEdge* edge, ADGNode* srcNode, ADGNode* dstN
 }
 
 
+// if the input port of the passthrough node is occupied by the edge with different srcId or srcPortIdx
+bool Mapping::isInPortConflict(DFGEdge* edge, int nodeId, int inPort){
+    if(!isAdgNodeInPortUsed(nodeId, inPort)){
+        return false;
+    }
+    for(auto& edgeLink : _adgNodeAttr[nodeId].dfgEdgePass){
+        auto passEdge = edgeLink.edge;
+        if(edgeLink.srcPort == inPort && (passEdge->srcId() != edge->srcId() || passEdge->srcPortIdx() != edge->srcPortIdx())){
+            return true;
+        }
+    }
+    return false;
+}
+
+
+// if the output port of the passthrough node is occupied by the edge with different srcId or srcPortIdx
+bool Mapping::isOutPortConflict(DFGEdge* edge, int nodeId, int outPort){
+    if(!isAdgNodeOutPortUsed(nodeId, outPort)){
+        return false;
+    }
+    for(auto& edgeLink : _adgNodeAttr[nodeId].dfgEdgePass){
+        auto passEdge = edgeLink.edge;
+        if(edgeLink.dstPort == outPort && (passEdge->srcId() != edge->srcId() || passEdge->srcPortIdx() != edge->srcPortIdx())){
+            return true;
+        }
+    }
+    return false;
+}
+
+
+// find a routable path between srcNode and dstNode by bidirectional BFS
+// the forward half expands <node-id, inport-index> from srcNode, the backward half expands <node-id, outport-index> from dstNode
+// two halves are joined in the passthrough node where one forward inport can be internally linked to one backward outport
+bool Mapping::routeDfgEdgeFromBoth(DFGEdge* edge, ADGNode* srcNode, ADGNode* dstNode, const std::set<int>& dstPortRange){
+    struct VisitNodeInfo{
+        int nodeId;     // previous node ID (src side for forward, dst side for backward)
+        int inPortIdx;  // input port index of the previous node
+        int outPortIdx; // output port index of the previous node
+    };
+    // cache forward visited node information, <<node-id, inport-index>, VisitNodeInfo>
+    std::map<std::pair<int, int>, VisitNodeInfo> fwdVisitNodes;
+    // cache backward visited node information, <<node-id, outport-index>, VisitNodeInfo>
+    std::map<std::pair<int, int>, VisitNodeInfo> bwdVisitNodes;
+    // current BFS layers, <node, port-index>, port-index = -1 : srcNode/dstNode
+    std::vector<std::pair<ADGNode*, int>> fwdLayer, bwdLayer;
+    int srcNodeId = srcNode->id();
+    int dstNodeId = dstNode->id();
+    int srcNodeOutPortIdx = edge->srcPortIdx();
+    // meeting status
+    bool success = false;
+    int meetNodeId = -1; // passthrough node joining two halves, -1: one half reaches the other end directly
+    int meetInPort = -1;
+    int meetOutPort = -1;
+    std::pair<int, int> fwdEnd = std::make_pair(-1, -1); // forward state reaching dstNode directly
+    std::pair<int, int> bwdEnd = std::make_pair(-1, -1); // backward state reaching srcNode directly
+    fwdLayer.push_back(std::make_pair(srcNode, -1));
+    bwdLayer.push_back(std::make_pair(dstNode, -1));
+    while(!success && !fwdLayer.empty() && !bwdLayer.empty()){
+        std::vector<std::pair<ADGNode*, int>> nextLayer;
+        if(fwdLayer.size() <= bwdLayer.size()){ // expand the smaller frontier, forward
+            for(auto& elem : fwdLayer){
+                ADGNode* adgNode = elem.first;
+                int inPortIdx = elem.second;
+                std::vector<int> outPortIdxs;
+                if(inPortIdx == -1){ // srcNode
+                    outPortIdxs.push_back(srcNodeOutPortIdx);
+                }else{
+                    for(int outPortIdx : adgNode->in2outs(inPortIdx)){
+                        if(routeDfgEdgePass(edge, adgNode, inPortIdx, outPortIdx, true)){
+                            outPortIdxs.push_back(outPortIdx);
+                        }
+                    }
+                }
+                for(int outPortIdx : outPortIdxs){
+                    for(auto& next : adgNode->output(outPortIdx)){
+                        auto nextId = next;
+                        ADGNode* nextNode = _adg->node(nextId.first);
+                        auto nextNodeType = nextNode->type();
+                        if(nextId.first == dstNodeId){
+                            if(!dstPortRange.count(nextId.second)){
+                                continue;
+                            }
+                            fwdEnd = nextId; // get to the dstNode
+                        } else if(nextNodeType == "GPE" || nextNodeType == "OB" || fwdVisitNodes.count(nextId) ||
+                                  isInPortConflict(edge, nextId.first, nextId.second)){
+                            continue;
+                        }
+                        VisitNodeInfo info;
+                        info.nodeId = adgNode->id();
+                        info.inPortIdx = inPortIdx;
+                        info.outPortIdx = outPortIdx;
+                        fwdVisitNodes[nextId] = info;
+                        if(fwdEnd.first != -1){
+                            success = true;
+                            break;
+                        }
+                        nextLayer.push_back(std::make_pair(nextNode, nextId.second));
+                        // check if meeting the backward half
+                        for(int meetOut : nextNode->in2outs(nextId.second)){
+                            if(bwdVisitNodes.count(std::make_pair(nextId.first, meetOut)) &&
+                               routeDfgEdgePass(edge, nextNode, nextId.second, meetOut, true)){
+                                success = true;
+                                meetNodeId = nextId.first;
+                                meetInPort = nextId.second;
+                                meetOutPort = meetOut;
+                                break;
+                            }
+                        }
+                        if(success) break;
+                    }
+                    if(success) break;
+                }
+                if(success) break;
+            }
+            fwdLayer = nextLayer;
+        } else { // backward
+            for(auto& elem : bwdLayer){
+                ADGNode* adgNode = elem.first;
+                int outPortIdx = elem.second;
+                std::vector<int> inPortIdxs;
+                if(outPortIdx == -1){ // dstNode
+                    inPortIdxs.assign(dstPortRange.begin(), dstPortRange.end());
+                }else{
+                    for(int inPortIdx : adgNode->out2ins(outPortIdx)){
+                        if(routeDfgEdgePass(edge, adgNode, inPortIdx, outPortIdx, true)){
+                            inPortIdxs.push_back(inPortIdx);
+                        }
+                    }
+                }
+                for(int inPortIdx : inPortIdxs){
+                    auto nextId = adgNode->input(inPortIdx);
+                    ADGNode* nextNode = _adg->node(nextId.first);
+                    if(nextNode == nullptr){ // connected to ADG input port
+                        continue;
+                    }
+                    auto nextNodeType = nextNode->type();
+                    if(nextId.first == srcNodeId){
+                        if(nextId.second != srcNodeOutPortIdx){
+                            continue;
+                        }
+                        bwdEnd = nextId; // get to the srcNode
+                    } else if(nextNodeType == "GPE" || nextNodeType == "IB" || bwdVisitNodes.count(nextId) ||
+                              isOutPortConflict(edge, nextId.first, nextId.second)){
+                        continue;
+                    }
+                    VisitNodeInfo info;
+                    info.nodeId = adgNode->id();
+                    info.inPortIdx = inPortIdx;
+                    info.outPortIdx = outPortIdx;
+                    bwdVisitNodes[nextId] = info;
+                    if(bwdEnd.first != -1){
+                        success = true;
+                        break;
+                    }
+                    nextLayer.push_back(std::make_pair(nextNode, nextId.second));
+                    // check if meeting the forward half
+                    for(int meetIn : nextNode->out2ins(nextId.second)){
+                        if(fwdVisitNodes.count(std::make_pair(nextId.first, meetIn)) &&
+                           routeDfgEdgePass(edge, nextNode, meetIn, nextId.second, true)){
+                            success = true;
+                            meetNodeId = nextId.first;
+                            meetInPort = meetIn;
+                            meetOutPort = nextId.second;
+                            break;
+                        }
+                    }
+                    if(success) break;
+                }
+                if(success) break;
+            }
+            bwdLayer = nextLayer;
+        }
+    }
+    if(!success){
+        return false;
+    }
+    // collect the passed links from srcNode to dstNode, <node-id, <srcPort, dstPort>>
+    std::vector<std::pair<int, std::pair<int, int>>> pathLinks;
+    std::pair<int, int> fwdState, bwdState; // <node-id, port-index>
+    if(fwdEnd.first != -1){ // forward half gets to the dstNode
+        pathLinks.push_back(std::make_pair(dstNodeId, std::make_pair(fwdEnd.second, -1)));
+        fwdState = fwdEnd;
+        bwdState = std::make_pair(-1, -1);
+    } else if(bwdEnd.first != -1){ // backward half gets to the srcNode
+        pathLinks.push_back(std::make_pair(srcNodeId, std::make_pair(-1, bwdEnd.second)));
+        fwdState = std::make_pair(-1, -1);
+        bwdState = bwdEnd;
+    } else{
+        pathLinks.push_back(std::make_pair(meetNodeId, std::make_pair(meetInPort, meetOutPort)));
+        fwdState = std::make_pair(meetNodeId, meetInPort);
+        bwdState = std::make_pair(meetNodeId, meetOutPort);
+    }
+    // forward half, from the meeting point back to srcNode
+    std::vector<std::pair<int, std::pair<int, int>>> fwdLinks;
+    while(fwdState.first != -1){
+        auto& info = fwdVisitNodes[fwdState];
+        fwdLinks.push_back(std::make_pair(info.nodeId, std::make_pair(info.inPortIdx, info.outPortIdx)));
+        if(info.nodeId == srcNodeId && info.inPortIdx == -1){
+            break;
+        }
+        fwdState = std::make_pair(info.nodeId, info.inPortIdx);
+    }
+    std::reverse(fwdLinks.begin(), fwdLinks.end());
+    pathLinks.insert(pathLinks.begin(), fwdLinks.begin(), fwdLinks.end());
+    // backward half, from the meeting point to dstNode
+    while(bwdState.first != -1){
+        auto& info = bwdVisitNodes[bwdState];
+        pathLinks.push_back(std::make_pair(info.nodeId, std::make_pair(info.inPortIdx, info.outPortIdx)));
+        if(info.nodeId == dstNodeId && info.outPortIdx == -1){
+            break;
+        }
+        bwdState = std::make_pair(info.nodeId, info.outPortIdx);
+    }
+    // route the found path
+    std::vector<EdgeLinkAttr> edgeLinks;
+    for(auto& link : pathLinks){
+        EdgeLinkAttr edgeAttr;
+        edgeAttr.srcPort = link.second.first;
+        edgeAttr.dstPort = link.second.second;
+        edgeAttr.adgNode = _adg->node(link.first);
+        edgeLinks.push_back(edgeAttr);
+    }
+    routeDfgEdgeLinks(edge, edgeLinks);
+    return true;
+}
+
+
+// route DFG edge along the given edge links from the src node to the dst node
+// srcPort = -1: src node; dstPort = -1: dst node; otherwise passthrough node
+void Mapping::routeDfgEdgeLinks(DFGEdge* edge, const std::vector<EdgeLinkAttr>& edgeLinks){
+    auto& routedLinks = _dfgEdgeAttr[edge->id()].edgeLinks;
+    for(auto& link : edgeLinks){
+        int nodeId = link.adgNode->id();
+        int srcPort = link.srcPort;
+        int dstPort = link.dstPort;
+        // keep the DFG edge routing status
+        routedLinks.push_back(link);
+        // keep the ADG Node routing status
+        ADGNodeAttr& nodeAttr = _adgNodeAttr[nodeId];
+        if(srcPort == -1){ // srcNode
+            nodeAttr.outPortUsed[dstPort] = true; // only change the output port status
+        } else if(dstPort == -1){ // dstNode
+            nodeAttr.inPortUsed[srcPort] = true;  // only change the input port status
+        } else{ // intermediate routing nodes or IB
+            nodeAttr.inPortUsed[srcPort] = true;
+            setAdgNodeOutPortUsed(nodeId, dstPort, true);
+            DfgEdgePassAttr passAttr;
+            passAttr.edge = edge;
+            passAttr.srcPort = srcPort;
+            passAttr.dstPort = dstPort;
+            nodeAttr.dfgEdgePass.push_back(passAttr);
+        }
+    }
+    updateEdgeLen(routedLinks.size(), true);
+    _schedDirtyEdges.emplace(edge->id());
+}
+
+
+// route DFG edge using the route templates from <srcNode, srcPort> to the available input ports of dstNode
+// srcPort: output port of GPE or input port of IB
+// only use the unblocked template as short as the shortest template, otherwise leave it to the search
+// return false if no such template
+bool Mapping::routeDfgEdgeByTemplates(DFGEdge* edge, ADGNode* srcNode, int srcPort, ADGNode* dstNode, const std::set<int>& dstPortRange){
+    if(_routeTemplates == nullptr){
+        return false;
+    }
+    int minLen = INT_MAX; // length of the shortest template
+    std::vector<EdgeLinkAttr> bestPath; // the shortest unblocked template, empty: none
+    for(int dstPort : dstPortRange){
+        for(auto& path : _routeTemplates->templates(srcNode->id(), srcPort, dstNode->id(), dstPort)){
+            int len = path.size();
+            minLen = std::min(minLen, len);
+            if(!bestPath.empty() && bestPath.size() <= len){
+                continue;
+            }
+            bool blocked = false;
+            for(auto& link : path){
+                if(link.srcPort == -1 || link.dstPort == -1){ // GPE src/dst node
+                    continue;
+                }
+                // passthrough node: check the occupancy and the shared-source rule
+                if(!routeDfgEdgePass(edge, link.adgNode, link.srcPort, link.dstPort, true)){
+                    blocked = true;
+                    break;
+                }
+            }
+            if(!blocked){
+                bestPath = path;
+            }
+        }
+    }
+    if(bestPath.empty() || bestPath.size() > minLen){
+        return false;
+    }
+    routeDfgEdgeLinks(edge, bestPath);
+    return true;
+}
+
+
 // find the available input ports in the dstNode to route edge
 std::set<int> Mapping::availDstPorts(DFGEdge* edge, ADGNode* dstNode){
     DFGNode* dstDfgNode = _dfg->node(edge->dstId());
@@ -706,14 +1039,124 @@ std::set<int> Mapping::availDstPorts(DFGEdge* edge, ADGNode* dstNode){
 }
 
 
+// if the srcNode can reach one of the available input ports of the dstNode on the free tracks
+// backward BFS over <node-id, outport-index> through GIB nodes, only check the port occupancy
+// maxDepth: max number of the GIB nodes to be searched in one path, optimistic if exceeded
+bool Mapping::isReachable(DFGEdge* edge, ADGNode* srcNode, ADGNode* dstNode, const std::set<int>& dstPortRange, int maxDepth){
+    int srcNodeId = srcNode->id();
+    int srcPortIdx = edge->srcPortIdx();
+    std::set<std::pair<int, int>> visited; // visited <node-id, outport-index>
+    std::vector<std::pair<int, int>> curLayer, nextLayer;
+    for(int dstPort : dstPortRange){
+        auto prevId = dstNode->input(dstPort);
+        if(prevId.first == srcNodeId && prevId.second == srcPortIdx){
+            return true;
+        }
+        curLayer.push_back(prevId);
+    }
+    for(int depth = 0; depth < maxDepth; depth++){
+        nextLayer.clear();
+        for(auto& id : curLayer){
+            ADGNode* adgNode = _adg->node(id.first);
+            if(adgNode == nullptr || adgNode->type() != "GIB" || visited.count(id) ||
+               isOutPortConflict(edge, id.first, id.second)){
+                continue;
+            }
+            visited.emplace(id);
+            for(int inPort : adgNode->out2ins(id.second)){
+                if(isInPortConflict(edge, id.first, inPort)){
+                    continue;
+                }
+                auto prevId = adgNode->input(inPort);
+                if(prevId.first == srcNodeId && prevId.second == srcPortIdx){
+                    return true;
+                }
+                nextLayer.push_back(prevId);
+            }
+        }
+        if(nextLayer.empty()){ // all the tracks are blocked
+            return false;
+        }
+        std::swap(curLayer, nextLayer);
+    }
+    return true;
+}
+
+
+// estimate if the edges between the DFG node and its mapped neighbors can be routed when mapping it to the candidate
+// check the free operands of the dst nodes and the bounded-depth reachability on the free tracks
+bool Mapping::estRoutable(DFGNode* dfgNode, ADGNode* candidate, int maxDepth){
+    // input edges whose src nodes have been mapped
+    for(auto& elem : dfgNode->inputEdges()){
+        DFGEdge* edge = _dfg->edge(elem.second);
+        if(edge->srcId() == _dfg->id()){ // connected to DFG input port
+            continue;
+        }
+        ADGNode* srcNode = mappedNode(_dfg->node(edge->srcId()));
+        if(srcNode && !isReachable(edge, srcNode, candidate, availDstPorts(edge, candidate), maxDepth)){
+            return false;
+        }
+    }
+    // output edges whose dst nodes have been mapped
+    std::map<int, int> dstEdgeCnt; // <dst-node-id, edge-number>
+    for(auto& elem : dfgNode->outputEdges()){
+        for(int eid : elem.second){
+            DFGEdge* edge = _dfg->edge(eid);
+            if(edge->dstId() == _dfg->id()){ // connected to DFG output port
+                continue;
+            }
+            DFGNode* dstDfgNode = _dfg->node(edge->dstId());
+            ADGNode* dstNode = mappedNode(dstDfgNode);
+            if(dstNode == nullptr){
+                continue;
+            }
+            std::set<int> dstPortRange = availDstPorts(edge, dstNode);
+            if(dstPortRange.empty() || !isReachable(edge, candidate, dstNode, dstPortRange, maxDepth)){
+                return false;
+            }
+            dstEdgeCnt[dstDfgNode->id()]++;
+        }
+    }
+    // commutative dst node: enough free operands for all the edges from this DFG node
+    for(auto& elem : dstEdgeCnt){
+        DFGNode* dstDfgNode = _dfg->node(elem.first);
+        if(elem.second < 2 || !dstDfgNode->commutative()){
+            continue;
+        }
+        GPENode* dstGpeNode = dynamic_cast<GPENode*>(mappedNode(dstDfgNode));
+        int freeOperands = 0;
+        for(int opIdx = 0; opIdx < dstDfgNode->numInputs(); opIdx++){
+            bool operandUsed = false;
+            for(int inPort : dstGpeNode->operandInputs(opIdx)){
+                if(isAdgNodeInPortUsed(dstGpeNode->id(), inPort)){
+                    operandUsed = true;
+                    break;
+                }
+            }
+            if(!operandUsed){
+                freeOperands++;
+            }
+        }
+        if(freeOperands < elem.second){
+            return false;
+        }
+    }
+    return true;
+}
+
+
 // route DFG edge between srcNode and dstNode
-// find a routable path from srcNode to dstNode by BFS
+// find a routable path between srcNode and dstNode by bidirectional BFS
 bool Mapping::routeDfgEdge(DFGEdge* edge, ADGNode* srcNode, ADGNode* dstNode){
     std::set<int> dstPortRange = availDstPorts(edge, dstNode); // the input port index range of the dstNode
     if(dstPortRange.empty()){ // no available input port in the dstNode
         return false;
     }
-    return routeDfgEdgeFromDst(edge, srcNode, dstNode, dstPortRange);
+    // try the route templates first, search only when all of them are blocked
+    if(routeDfgEdgeByTemplates(edge, srcNode, edge->srcPortIdx(), dstNode, dstPortRange)){
+        return true;
+    }
+    return routeDfgEdgeFromBoth(edge, srcNode, dstNode, dstPortRange);
     // if(!routeDfgEdgeFromDst(edge, srcNode, dstNode, dstPortRange)){
     //     return routeDfgEdgeFromSrc(edge, srcNode, dstNode, dstPortRange);
     // }
@@ -732,6 +1175,15 @@ bool Mapping::routeDfgEdge(DFGEdge* edge, ADGNode* adgNode, bool is2Input){
     if(dstPortRange.empty()){ // no available input port in the dstNode
         return false;
     }
+    int inputIdx = edge->srcPortIdx();
+    if(isDfgInputMapped(inputIdx)){ // the IB is fixed if the DFG input port is already mapped
+        for(auto& elem : _adg->input(_dfgInputAttr[inputIdx].adgIOPort)){
+            if(routeDfgEdgeByTemplates(edge, _adg->node(elem.first), elem.second, adgNode, dstPortRange)){
+                _dfgInputAttr[inputIdx].routedEdgeIds.emplace(edge->id());
+                return true;
+            }
+        }
+    }
     return routeDfgEdgeFromDst(edge, nullptr, adgNode, dstPortRange);
 }
 
@@ -773,7 +1225,7 @@ void Mapping::unrouteDfgEdge(DFGEdge* edge){
             nodeAttr.inPortUsed[edgeLink.srcPort] = false;
         }
         if(setOutPortUsed){
-            nodeAttr.outPortUsed[edgeLink.dstPort] = false;
+            setAdgNodeOutPortUsed(node->id(), edgeLink.dstPort, false);
         } 
         // if(edgeLink.srcPort != -1){
         //     nodeAttr.inPortUsed[edgeLink.srcPort] = false;
@@ -783,6 +1235,8 @@ void Mapping::unrouteDfgEdge(DFGEdge* edge){
         // } 
         // }              
     }
+    updateEdgeLen(edgeAttr.edgeLinks.size(), false);
+    _schedDirtyEdges.emplace(eid);
     _dfgEdgeAttr.erase(eid);
     // unmap DFG IO
     if(edge->srcId() == _dfg->id()){ // connected to DFG input port
@@ -804,15 +1258,25 @@ bool Mapping::success(){
 
 // total/max edge length (link number)
 void Mapping::getEdgeLen(int& totalLen, int& maxLen){
-    int total = 0;
-    int maxVal = 0;
-    for(auto& elem : _dfgEdgeAttr){
-        int num = elem.second.edgeLinks.size();
-        total += num;
-        maxVal = std::max(maxVal, num);
+    totalLen = _totalEdgeLen;
+    maxLen = _edgeLenCnt.empty()? 0 : _edgeLenCnt.rbegin()->first;
+}
+
+
+// add/remove the length of one routed DFG edge to/from the edge length statistics
+void Mapping::updateEdgeLen(int len, bool add){
+    if(len == 0){ // not routed
+        return;
+    }
+    if(add){
+        _edgeLenCnt[len]++;
+        _totalEdgeLen += len;
+    } else{
+        if(--_edgeLenCnt[len] == 0){
+            _edgeLenCnt.erase(len);
+        }
+        _totalEdgeLen -= len;
     }
-    totalLen = total;
-    maxLen = maxVal;
 }
 
 
@@ -861,21 +1325,45 @@ void Mapping::assignDfgIO(){
 // calculate the routing latency of each edge, not inlcuding the delay pipe
 void Mapping::calEdgeRouteLat(){
     for(auto& elem : _dfgEdgeAttr){
-        auto& attr = elem.second;
-        int lat = 0;
-        for(auto& linkAttr : attr.edgeLinks){
-            if(linkAttr.adgNode->type() == "GIB"){ // edge only pass-through GIB nodes
-                bool reged = dynamic_cast<GIBNode*>(linkAttr.adgNode)->outReged(linkAttr.dstPort); // output port reged
-                lat += reged;
-            }
+        calEdgeRouteLat(elem.first);
+    }
+}
+
+
+// calculate the routing latency of one edge, not inlcuding the delay pipe
+void Mapping::calEdgeRouteLat(int eid){
+    auto& attr = _dfgEdgeAttr[eid];
+    int lat = 0;
+    for(auto& linkAttr : attr.edgeLinks){
+        if(linkAttr.adgNode->type() == "GIB"){ // edge only pass-through GIB nodes
+            bool reged = dynamic_cast<GIBNode*>(linkAttr.adgNode)->outReged(linkAttr.dstPort); // output port reged
+            lat += reged;
         }
-        attr.lat = lat;
-        // attr.latNoDelay = lat;
     }
+    attr.lat = lat;
+    attr.latNoDelay = lat;
 }
 
 
-// calculate the DFG node latency bounds not considering the Delay components, including 
+// calculate the latency lower bound of the DFG node output port according to its src nodes
+int Mapping::calLatencyBound(DFGNode* node){
+    int maxLat = 0; // max latency of the input ports
+    for(auto& elem : node->inputEdges()){
+        int eid = elem.second;
+        int routeLat = _dfgEdgeAttr[eid].latNoDelay;
+        int srcNodeId = _dfg->edge(eid)->srcId();
+        int srcNodeLat = 0; // DFG input port min latency = 0
+        if(srcNodeId != _dfg->id()){ // not connected to DFG input port
+            srcNodeLat = _dfgNodeAttr[srcNodeId].lbLat;
+        }
+        int inPortLat = srcNodeLat + routeLat;
+        maxLat = std::max(maxLat, inPortLat);
+    }
+    return maxLat + node->opLatency();
+}
+
+
+// calculate the DFG node latency bounds not considering the Delay components, including
 // min latency of the output ports
 // ID of the DFG node with the max latency
 void Mapping::latencyBound(){
@@ -883,35 +1371,14 @@ void Mapping::latencyBound(){
     int maxLatNodeId;  // ID of the DFG node with the max latency
     // calculate the LOWER bounds in topological order
     for(DFGNode* node : _dfg->topoNodes()){
-        int maxLat = 0; // max latency of the input ports
         int nodeId = node->id();
-        int nodeOpLat = _dfg->node(nodeId)->opLatency(); // operation latency
-        for(auto& elem : node->inputEdges()){
-            int eid = elem.second;
-            int routeLat = _dfgEdgeAttr[eid].lat; // latNoDelay;
-            int srcNodeId = _dfg->edge(eid)->srcId();
-            int srcNodeLat = 0; // DFG input port min latency = 0
-            if(srcNodeId != _dfg->id()){ // not connected to DFG input port
-                srcNodeLat = _dfgNodeAttr[srcNodeId].lat;                
-            }
-            int inPortLat = srcNodeLat + routeLat; 
-            maxLat = std::max(maxLat, inPortLat);
-        }
-        // for(auto& elem : node->inputs()){
-        //     int srcNodeId = elem.second.first;
-        //     int srcNodeLat = 0;
-        //     if(srcNodeId != _dfg->id()){ // not connected to DFG input port
-        //         srcNodeLat = _dfgNodeAttr[srcNodeId].lat;                
-        //     }
-        //     int inPortLat = srcNodeLat; // edge no latency
-        //     maxLat = std::max(maxLat, inPortLat);
-        // }
-        int lat = maxLat + nodeOpLat;
+        int lat = calLatencyBound(node);
+        _dfgNodeAttr[nodeId].lbLat = lat;
         _dfgNodeAttr[nodeId].lat = lat;
         if(lat >= maxLatDfg){
             maxLatDfg = lat;
             maxLatNodeId = nodeId;
-        }       
+        }
     }
     // _maxLat = maxLatDfg;
     _maxLatNodeId = maxLatNodeId;
@@ -920,130 +1387,455 @@ void Mapping::latencyBound(){
 
 // schedule the latency of each DFG node based on the mapping status
 // DFG node latency: output port latency
-// DFG edge latency: latency from the output port of src node to the ALU Input port of dst Node, including DelayPipe 
+// DFG edge latency: latency from the output port of src node to the ALU Input port of dst Node, including DelayPipe
+// only reschedule the DFG nodes affected by the changes since the last scheduling if possible
 void Mapping::latencySchedule(){
-    std::set<int> scheduledNodeIds;  
-    std::vector<DFGNode*> unscheduledNodes = _dfg->topoNodes();
-    std::reverse(unscheduledNodes.begin(), unscheduledNodes.end()); // in reversed topological order
+    if(_dfg->hasBackEdge()){ // the greedy schedules follow the topological order, ignoring the back edges
+        calEdgeRouteLat();
+        latencyScheduleDC();
+        _schedValid = false;
+        _schedDirtyEdges.clear();
+        _schedDirtyNodes.clear();
+        return;
+    }
+    if(_dfgNodeTopoIdx.size() != _dfg->topoNodes().size()){
+        _dfgNodeTopoIdx.clear();
+        int idx = 0;
+        for(DFGNode* node : _dfg->topoNodes()){
+            _dfgNodeTopoIdx[node->id()] = idx++;
+        }
+    }
+    if(!_schedValid || !latencyScheduleIncr()){
+        latencyScheduleFull();
+    }
+    _schedValid = true;
+    _schedDirtyEdges.clear();
+    _schedDirtyNodes.clear();
+    if(_totalViolation == 0){
+        return;
+    }
+    // try to reduce the violations by solving the difference constraints, keep the better schedule
+    struct EdgeLat{ int lat, delay, vio; };
+    std::map<int, EdgeLat> edgeLats;
+    for(auto& elem : _dfgEdgeAttr){
+        edgeLats[elem.first] = {elem.second.lat, elem.second.delay, elem.second.vio};
+    }
+    auto nodeAttr = _dfgNodeAttr;
+    auto inputAttr = _dfgInputAttr;
+    auto outputAttr = _dfgOutputAttr;
+    auto vioDfgEdges = _vioDfgEdges;
+    int totalVio = _totalViolation;
+    int maxVio = _maxViolation;
+    int maxLat = _maxLat;
+    latencyScheduleDC();
+    if(_totalViolation < totalVio || (_totalViolation == totalVio && _maxLat < maxLat)){
+        _schedValid = false; // the incremental scheduling is based on the greedy schedule
+        return;
+    }
+    for(auto& elem : edgeLats){
+        auto& attr = _dfgEdgeAttr[elem.first];
+        attr.lat = elem.second.lat;
+        attr.delay = elem.second.delay;
+        attr.vio = elem.second.vio;
+    }
+    _dfgNodeAttr = nodeAttr;
+    _dfgInputAttr = inputAttr;
+    _dfgOutputAttr = outputAttr;
+    _vioDfgEdges = vioDfgEdges;
+    _totalViolation = totalVio;
+    _maxViolation = maxVio;
+    _maxLat = maxLat;
+}
+
+
+// schedule the latency by solving the difference constraints of the DFG edges
+// variables: output port latency of each DFG node and latency of each DFG input port
+// edge (u, v): 0 <= delay = (lat(v) - opLat(v)) - (lat(u) + routeLat) <= maxDelay(v)
+// the least solution is found by the longest-path SPFA, which also minimizes the max latency
+// for each positive cycle (infeasible), relax one upper bound (max delay) constraint in it by the cycle weight,
+// and the edge of the relaxed constraint becomes the violated edge
+// each SPFA starts from the lower bounds of the forward edges, which are never relaxed,
+// after relaxing too many cycles, all the upper bound constraints are dropped at once to bound the SPFA rounds
+// back edge (u, v) with iteration distance d: lat(u) - d * II is used as the src latency,
+// the recurrence cycle without upper bound constraint relaxes the lower bound constraint of its back edge,
+// i.e. the loop-carried value arrives too late for the II
+void Mapping::latencyScheduleDC(){
+    struct Constraint{
+        int from;   // lat(to) >= lat(from) + weight
+        int to;
+        int weight;
+        bool upper; // upper bound of the delay
+        bool back;  // constraint of the back edge
+    };
+    std::map<int, int> varIdx; // <DFG node id, variable index>
+    std::map<int, int> inputVarIdx; // <DFG input port index, variable index>
+    std::vector<int> initLat; // initial latency of each variable
+    for(DFGNode* node : _dfg->topoNodes()){
+        varIdx[node->id()] = initLat.size();
+        initLat.push_back(node->opLatency());
+    }
+    for(auto& elem : _dfg->inputEdges()){
+        inputVarIdx[elem.first] = initLat.size();
+        initLat.push_back(0);
+    }
+    int numVars = initLat.size();
+    std::vector<Constraint> constraints;
+    std::vector<std::vector<int>> varCons(numVars); // constraint indexes starting from each variable
+    for(DFGNode* node : _dfg->topoNodes()){
+        int v = varIdx[node->id()];
+        int maxDelay = dynamic_cast<GPENode*>(_dfgNodeAttr[node->id()].adgNode)->maxDelay();
+        for(auto& elem : node->inputEdges()){
+            DFGEdge* edge = _dfg->edge(elem.second);
+            int u = (edge->srcId() == _dfg->id())? inputVarIdx[edge->srcPortIdx()] : varIdx[edge->srcId()];
+            int minDist = _dfgEdgeAttr[edge->id()].latNoDelay + node->opLatency() - edge->iterDist() * _ii;
+            varCons[u].push_back(constraints.size());
+            constraints.push_back({u, v, minDist, false, edge->isBackEdge()});
+            varCons[v].push_back(constraints.size());
+            constraints.push_back({v, u, -(minDist + maxDelay), true, edge->isBackEdge()});
+            if(!edge->isBackEdge()){ // the src node is before in topological order
+                initLat[v] = std::max(initLat[v], initLat[u] + minDist);
+            }
+        }
+    }
+    const int maxRelaxCycles = 16; // max cycles relaxed one by one
+    const int dropWeight = -(1 << 24); // weight of the dropped upper bound constraint, never binding
+    int numRelaxCycles = 0;
+    // longest-path SPFA, restart after relaxing one constraint in the found positive cycle
+    std::vector<int> lat;
+    while(true){
+        lat = initLat;
+        std::vector<int> relaxCnt(numVars, 0);
+        std::vector<int> pred(numVars, -1); // constraint relaxing the variable last
+        std::vector<bool> inQue(numVars, true);
+        std::deque<int> que;
+        for(int i = 0; i < numVars; i++){
+            que.push_back(i);
+        }
+        int cycleVar = -1; // variable relaxed too many times, reached from a positive cycle
+        while(!que.empty() && cycleVar < 0){
+            int u = que.front();
+            que.pop_front();
+            inQue[u] = false;
+            for(int ci : varCons[u]){
+                auto& c = constraints[ci];
+                if(lat[u] + c.weight <= lat[c.to]){
+                    continue;
+                }
+                lat[c.to] = lat[u] + c.weight;
+                pred[c.to] = ci;
+                if(++relaxCnt[c.to] > numVars){
+                    cycleVar = c.to;
+                    break;
+                }
+                if(!inQue[c.to]){
+                    inQue[c.to] = true;
+                    que.push_back(c.to);
+                }
+            }
+        }
+        if(cycleVar < 0){ // feasible
+            break;
+        }
+        if(++numRelaxCycles > maxRelaxCycles){ // drop all the upper bound constraints, the left cycles have back edges
+            bool dropped = false;
+            for(auto& c : constraints){
+                if(c.upper && c.weight > dropWeight){
+                    c.weight = dropWeight;
+                    dropped = true;
+                }
+            }
+            if(dropped){
+                continue;
+            }
+        }
+        // walk back along the predecessors into the cycle
+        for(int i = 0; i < numVars && pred[cycleVar] >= 0; i++){
+            cycleVar = constraints[pred[cycleVar]].from;
+        }
+        int relaxIdx = -1; // upper bound constraint to be relaxed
+        int backIdx = -1;  // lower bound constraint of the back edge, relaxed if no upper bound constraint in the cycle
+        int cycleWeight = 0;
+        int var = cycleVar;
+        do{
+            int ci = pred[var];
+            if(ci < 0){
+                break;
+            }
+            if(constraints[ci].upper && relaxIdx < 0){
+                relaxIdx = ci;
+            }
+            if(!constraints[ci].upper && constraints[ci].back && backIdx < 0){
+                backIdx = ci;
+            }
+            cycleWeight += constraints[ci].weight;
+            var = constraints[ci].from;
+        } while(var != cycleVar);
+        if(relaxIdx < 0){
+            relaxIdx = backIdx;
+        }
+        // should not happen, the lower bound constraints of the forward edges follow the topological order
+        if(relaxIdx < 0 || cycleWeight <= 0){
+            return;
+        }
+        constraints[relaxIdx].weight -= cycleWeight;
+    }
+    // schedule the DFG nodes according to the solution
+    for(DFGNode* node : _dfg->topoNodes()){
+        auto& attr = _dfgNodeAttr[node->id()];
+        GPENode* gpeNode = dynamic_cast<GPENode*>(attr.adgNode); // mapped GPE node
+        attr.lat = lat[varIdx[node->id()]];
+        attr.maxLat = attr.lat - node->opLatency(); // input port max latency
+        attr.minLat = std::max(attr.maxLat - gpeNode->maxDelay(), 0); // input port min latency
+    }
+    // calculate the latency of DFG IO
+    calIOLat();
+    // calculate the latency violation of each edge
+    calEdgeLatVio();
+}
+
+
+// schedule the latency of all the DFG nodes
+void Mapping::latencyScheduleFull(){
     // calculate the routing latency of each edge, not inlcuding the delay pipe
     calEdgeRouteLat();
-    // calculate the DFG node latency bounds, finding the max-latency path 
+    // calculate the DFG node latency bounds, finding the max-latency path
     latencyBound();
     // schedule the DFG nodes in the max-latency path
+    _critPathNodeIds = critPathNodes();
+    for(int nodeId : _critPathNodeIds){
+        scheduleCritDfgNode(_dfg->node(nodeId));
+    }
+    // schedule the DFG nodes not in the max-latency path in reversed topological order
+    // all the dst nodes of one DFG node are scheduled before it
+    auto& topoNodes = _dfg->topoNodes();
+    for(auto iter = topoNodes.rbegin(); iter != topoNodes.rend(); iter++){
+        if(!_critPathNodeIds.count((*iter)->id())){
+            scheduleDfgNode(*iter);
+        }
+    }
+    // calculate the latency of DFG IO
+    calIOLat();
+    // calculate the latency violation of each edge
+    calEdgeLatVio();
+}
+
+
+// reschedule the DFG nodes affected by the changed edges and nodes since the last scheduling
+// the latency lower bounds are propagated through the fan-out cone of the changes,
+// the scheduled latencies through the fan-in cone of the nodes with changed bounds
+// return false if the max-latency path changes, need to schedule all the DFG nodes
+bool Mapping::latencyScheduleIncr(){
+    if(_schedDirtyEdges.size() + _schedDirtyNodes.size() > _dfg->edges().size()/4){ // full scheduling is faster
+        return false;
+    }
+    std::set<int> boundSeeds; // DFG nodes whose input edges changed
+    std::set<int> schedSeeds; // DFG nodes whose output edges or latency lower bounds changed
+    for(int eid : _schedDirtyEdges){
+        if(!_dfgEdgeAttr.count(eid)){ // not routed
+            return false;
+        }
+        calEdgeRouteLat(eid);
+        DFGEdge* edge = _dfg->edge(eid);
+        if(edge->dstId() != _dfg->id()){
+            boundSeeds.emplace(edge->dstId());
+        }
+        if(edge->srcId() != _dfg->id()){
+            schedSeeds.emplace(edge->srcId());
+        }
+    }
+    for(int id : _schedDirtyNodes){ // the mapped ADG node changed
+        boundSeeds.emplace(id);
+        schedSeeds.emplace(id);
+    }
+    // propagate the latency lower bounds through the fan-out cone in topological order
+    std::set<std::pair<int, int>> nodeQue; // <topo-index, node-id>
+    for(int id : boundSeeds){
+        nodeQue.emplace(_dfgNodeTopoIdx[id], id);
+    }
+    int maxLatDfg = _dfgNodeAttr[_maxLatNodeId].lbLat;
+    int maxLatNodeIdx = _dfgNodeTopoIdx[_maxLatNodeId];
+    while(!nodeQue.empty()){
+        int nodeId = nodeQue.begin()->second;
+        int nodeIdx = nodeQue.begin()->first;
+        nodeQue.erase(nodeQue.begin());
+        DFGNode* node = _dfg->node(nodeId);
+        int lat = calLatencyBound(node);
+        if(lat == _dfgNodeAttr[nodeId].lbLat){
+            continue;
+        }
+        if(nodeId == _maxLatNodeId || lat > maxLatDfg || (lat == maxLatDfg && nodeIdx > maxLatNodeIdx)){ // max-latency node changes
+            return false;
+        }
+        _dfgNodeAttr[nodeId].lbLat = lat;
+        schedSeeds.emplace(nodeId);
+        for(auto& elem : node->outputs()){
+            for(auto& outNode : elem.second){
+                if(outNode.first != _dfg->id()){ // not connected to DFG output port
+                    nodeQue.emplace(_dfgNodeTopoIdx[outNode.first], outNode.first);
+                }
+            }
+        }
+    }
+    // the max-latency path should keep the same
+    if(critPathNodes() != _critPathNodeIds){
+        return false;
+    }
+    std::set<int> changedNodes; // DFG nodes with changed scheduled latency
+    for(int nodeId : _critPathNodeIds){
+        DFGNode* node = _dfg->node(nodeId);
+        if(!scheduleCritDfgNode(node)){
+            continue;
+        }
+        changedNodes.emplace(nodeId);
+        for(auto& elem : node->inputs()){
+            schedSeeds.emplace(elem.second.first);
+        }
+    }
+    schedSeeds.erase(_dfg->id());
+    // reschedule the DFG nodes not in the max-latency path through the fan-in cone in reversed topological order
+    for(int id : schedSeeds){
+        if(!_critPathNodeIds.count(id)){
+            nodeQue.emplace(_dfgNodeTopoIdx[id], id);
+        }
+    }
+    while(!nodeQue.empty()){
+        auto iter = std::prev(nodeQue.end());
+        int nodeId = iter->second;
+        nodeQue.erase(iter);
+        DFGNode* node = _dfg->node(nodeId);
+        if(!scheduleDfgNode(node)){
+            continue;
+        }
+        changedNodes.emplace(nodeId);
+        for(auto& elem : node->inputs()){
+            int srcNodeId = elem.second.first;
+            if(srcNodeId != _dfg->id() && !_critPathNodeIds.count(srcNodeId)){
+                nodeQue.emplace(_dfgNodeTopoIdx[srcNodeId], srcNodeId);
+            }
+        }
+    }
+    // calculate the latency of DFG IO
+    calIOLat();
+    // recalculate the latency violation of the edges connected to the changed nodes and DFG input ports
+    std::set<int> edgeIds = _schedDirtyEdges;
+    for(int id : changedNodes){
+        DFGNode* node = _dfg->node(id);
+        for(auto& elem : node->inputEdges()){
+            edgeIds.emplace(elem.second);
+        }
+        for(auto& elem : node->outputEdges()){
+            edgeIds.insert(elem.second.begin(), elem.second.end());
+        }
+    }
+    for(auto& elem : _dfg->inputEdges()){
+        edgeIds.insert(elem.second.begin(), elem.second.end());
+    }
+    std::set<int> vioEdgeIds(_vioDfgEdges.begin(), _vioDfgEdges.end());
+    for(int eid : edgeIds){
+        if(_dfg->edge(eid)->dstId() == _dfg->id()){ // connected to DFG output port
+            continue;
+        }
+        if(calEdgeLatVio(eid) > 0){
+            vioEdgeIds.emplace(eid);
+        } else{
+            vioEdgeIds.erase(eid);
+        }
+    }
+    // keep the same order as calEdgeLatVio()
+    _vioDfgEdges.assign(vioEdgeIds.begin(), vioEdgeIds.end());
+    std::sort(_vioDfgEdges.begin(), _vioDfgEdges.end(), [&](int a, int b){
+        DFGEdge* ea = _dfg->edge(a);
+        DFGEdge* eb = _dfg->edge(b);
+        int ia = _dfgNodeTopoIdx[ea->dstId()];
+        int ib = _dfgNodeTopoIdx[eb->dstId()];
+        return (ia < ib) || (ia == ib && ea->dstPortIdx() < eb->dstPortIdx());
+    });
+    _totalViolation = 0;
+    _maxViolation = 0;
+    for(int eid : _vioDfgEdges){
+        int vio = _dfgEdgeAttr[eid].vio;
+        _totalViolation += vio;
+        _maxViolation = std::max(_maxViolation, vio);
+    }
+    return true;
+}
+
+
+// find the DFG nodes in the max-latency path according to the latency lower bounds
+std::set<int> Mapping::critPathNodes(){
+    std::set<int> nodeIds;
     DFGNode* dfgNode = _dfg->node(_maxLatNodeId);
-    scheduledNodeIds.emplace(dfgNode->id());
-    auto iterEnd = std::remove(unscheduledNodes.begin(), unscheduledNodes.end(), dfgNode);
-    // unscheduledNodes.erase(std::remove(unscheduledNodes.begin(), unscheduledNodes.end(), dfgNode), unscheduledNodes.end());
     while(dfgNode){ // until getting to the input port
-        int nodeId = dfgNode->id();     
-        // std::cout << "id: " << nodeId << std::endl;   
-        // use the latency lower bound as the target latency
-        int inPortLat = _dfgNodeAttr[nodeId].lat - _dfg->node(nodeId)->opLatency(); // input port latency
-        GPENode* gpeNode = dynamic_cast<GPENode*>(_dfgNodeAttr[nodeId].adgNode); // mapped GPE node
-        _dfgNodeAttr[nodeId].maxLat = inPortLat; // input port max latency 
-        _dfgNodeAttr[nodeId].minLat = std::max(inPortLat - gpeNode->maxDelay(), 0); // input port min latency 
+        nodeIds.emplace(dfgNode->id());
+        int inPortLat = _dfgNodeAttr[dfgNode->id()].lbLat - dfgNode->opLatency(); // input port latency
         DFGNode* srcNode = nullptr;
         for(auto& elem : dfgNode->inputEdges()){
             int eid = elem.second;
-            int routeLat = _dfgEdgeAttr[eid].lat; // latNoDelay;
+            int routeLat = _dfgEdgeAttr[eid].latNoDelay;
             int srcNodeId = _dfg->edge(eid)->srcId();
             if(srcNodeId == _dfg->id()){ // connected to DFG input port
-                continue;               
+                continue;
             }
-            int srcNodeLat = _dfgNodeAttr[srcNodeId].lat;             
-            if(inPortLat == srcNodeLat + routeLat){ 
-                scheduledNodeIds.emplace(srcNodeId); // latency fixed
+            if(inPortLat == _dfgNodeAttr[srcNodeId].lbLat + routeLat){
                 srcNode = _dfg->node(srcNodeId);
-                iterEnd = std::remove(unscheduledNodes.begin(), iterEnd, srcNode);
-                // unscheduledNodes.erase(std::remove(unscheduledNodes.begin(), unscheduledNodes.end(), srcNode), unscheduledNodes.end());
                 break; // only find one path
-            } 
+            }
         }
-        // for(auto& elem : dfgNode->inputs()){
-        //     int srcNodeId = elem.second.first;
-        //     if(srcNodeId == _dfg->id()){ // connected to DFG input port
-        //         continue;               
-        //     }
-        //     int srcNodeLat = _dfgNodeAttr[srcNodeId].lat;             
-        //     if(inPortLat == srcNodeLat){ // edge no latency
-        //         scheduledNodeIds.emplace(srcNodeId); // latency fixed
-        //         srcNode = _dfg->node(srcNodeId);
-        //         iterEnd = std::remove(unscheduledNodes.begin(), iterEnd, srcNode);
-        //         // unscheduledNodes.erase(std::remove(unscheduledNodes.begin(), unscheduledNodes.end(), srcNode), unscheduledNodes.end());
-        //         break; // only find one path
-        //     } 
-        // }
         dfgNode = srcNode;
     }
-    unscheduledNodes.erase(iterEnd, unscheduledNodes.end());
-    // schedule the DFG nodes not in the max-latency path
-    while(!unscheduledNodes.empty()){
-        for(auto iter = unscheduledNodes.begin(); iter != unscheduledNodes.end();){
-            dfgNode = *iter;
-            int nodeId = dfgNode->id();
-            // std::cout << "id: " << nodeId << std::endl;
-            int maxLat = 0x3fffffff;
-            int minLat = 0;
-            bool fail = false; // fail to schedule this DFG node
-            bool updated = false; // maxLat/minLat UPDATED
-            // schedule DFG node only if all its output nodes are already scheduled 
-            // for(auto& outsPerPort : dfgNode->outputs()){
-            //     for(auto& elem : outsPerPort.second){
-            //         int dstNodeId = elem.first;
-            //         if(dstNodeId == _dfg->id()){ // connected to DFG output port
-            //             continue;
-            //         }
-            //         if(scheduledNodeIds.count(dstNodeId)){ // already scheduled                     
-            //             maxLat = std::min(maxLat, _dfgNodeAttr[dstNodeId].maxLat);
-            //             minLat = std::max(minLat, _dfgNodeAttr[dstNodeId].minLat);
-            //             updated = true;
-            //         }else{
-            //             fail = true;
-            //             break;
-            //         }
-            //     }
-            //     if(fail) break;
-            // }
-            for(auto& outsPerPort : dfgNode->outputEdges()){
-                for(auto& eid : outsPerPort.second){
-                    int routeLat = _dfgEdgeAttr[eid].lat; // latNoDelay;
-                    int dstNodeId = _dfg->edge(eid)->dstId();
-                    if(dstNodeId == _dfg->id()){ // connected to DFG output port
-                        continue;
-                    }
-                    if(scheduledNodeIds.count(dstNodeId)){ // already scheduled                     
-                        maxLat = std::min(maxLat, _dfgNodeAttr[dstNodeId].maxLat - routeLat);
-                        minLat = std::max(minLat, _dfgNodeAttr[dstNodeId].minLat - routeLat);
-                        updated = true;
-                    }else{
-                        fail = true;
-                        break;
-                    }
-                }
-                if(fail) break;
-            }
-            if(fail){
-                iter++;
+    return nodeIds;
+}
+
+
+// schedule the DFG node in the max-latency path, use the latency lower bound as the target latency
+// return true if the latency of this DFG node changed
+bool Mapping::scheduleCritDfgNode(DFGNode* dfgNode){
+    auto& attr = _dfgNodeAttr[dfgNode->id()];
+    GPENode* gpeNode = dynamic_cast<GPENode*>(attr.adgNode); // mapped GPE node
+    int inPortMaxLat = attr.lbLat - dfgNode->opLatency(); // input port max latency
+    int inPortMinLat = std::max(inPortMaxLat - gpeNode->maxDelay(), 0); // input port min latency
+    bool changed = (attr.lat != attr.lbLat) || (attr.maxLat != inPortMaxLat) || (attr.minLat != inPortMinLat);
+    attr.lat = attr.lbLat;
+    attr.maxLat = inPortMaxLat;
+    attr.minLat = inPortMinLat;
+    return changed;
+}
+
+
+// schedule the DFG node not in the max-latency path according to its scheduled dst nodes
+// return true if the latency of this DFG node changed
+bool Mapping::scheduleDfgNode(DFGNode* dfgNode){
+    int nodeId = dfgNode->id();
+    int maxLat = 0x3fffffff;
+    int minLat = 0;
+    bool updated = false; // maxLat/minLat UPDATED
+    for(auto& outsPerPort : dfgNode->outputEdges()){
+        for(auto& eid : outsPerPort.second){
+            int routeLat = _dfgEdgeAttr[eid].latNoDelay;
+            int dstNodeId = _dfg->edge(eid)->dstId();
+            if(dstNodeId == _dfg->id()){ // connected to DFG output port
                 continue;
-            } 
-            // if all its output ports are connected to DFG output ports, keep original latency
-            // otherwise, update the latency
-            int targetLat = _dfgNodeAttr[nodeId].lat; 
-            if(updated){
-                targetLat = std::max(targetLat, std::min(maxLat, minLat));
-                _dfgNodeAttr[nodeId].lat = targetLat;
-            }            
-            GPENode* gpeNode = dynamic_cast<GPENode*>(_dfgNodeAttr[nodeId].adgNode); // mapped GPE node
-            _dfgNodeAttr[nodeId].maxLat = targetLat - _dfg->node(nodeId)->opLatency(); // input port max latency 
-            _dfgNodeAttr[nodeId].minLat = std::max(_dfgNodeAttr[nodeId].maxLat - gpeNode->maxDelay(), 0); // input port min latency 
-            scheduledNodeIds.emplace(nodeId); // latency fixed
-            iter = unscheduledNodes.erase(iter);
+            }
+            maxLat = std::min(maxLat, _dfgNodeAttr[dstNodeId].maxLat - routeLat);
+            minLat = std::max(minLat, _dfgNodeAttr[dstNodeId].minLat - routeLat);
+            updated = true;
         }
     }
-    // calculate the latency of DFG IO
-    calIOLat();
-    // calculate the latency violation of each edge
-    calEdgeLatVio();
+    auto& attr = _dfgNodeAttr[nodeId];
+    // if all its output ports are connected to DFG output ports, keep the latency lower bound
+    // otherwise, update the latency
+    int targetLat = attr.lbLat;
+    if(updated){
+        targetLat = std::max(targetLat, std::min(maxLat, minLat));
+    }
+    GPENode* gpeNode = dynamic_cast<GPENode*>(attr.adgNode); // mapped GPE node
+    int inPortMaxLat = targetLat - dfgNode->opLatency(); // input port max latency
+    int inPortMinLat = std::max(inPortMaxLat - gpeNode->maxDelay(), 0); // input port min latency
+    bool changed = (attr.lat != targetLat) || (attr.maxLat != inPortMaxLat) || (attr.minLat != inPortMinLat);
+    attr.lat = targetLat;
+    attr.maxLat = inPortMaxLat;
+    attr.minLat = inPortMinLat;
+    return changed;
 }
 
 
@@ -1054,7 +1846,7 @@ void Mapping::calIOLat(){
         int minLat = 0;
         int maxLat = 0x3fffffff;
         for(auto& eid : insPerPort.second){
-            int routeLat = _dfgEdgeAttr[eid].lat; // latNoDelay;
+            int routeLat = _dfgEdgeAttr[eid].latNoDelay;
             int dstNodeId = _dfg->edge(eid)->dstId();
             if(dstNodeId == _dfg->id()){ // connected to DFG output port
                 continue;
@@ -1069,11 +1861,11 @@ void Mapping::calIOLat(){
     // DFG output port latency
     for(auto& elem : _dfg->outputEdges()){
         int eid = elem.second;
-        int routeLat = _dfgEdgeAttr[eid].lat; // latNoDelay;
+        int routeLat = _dfgEdgeAttr[eid].latNoDelay;
         int srcNodeId = _dfg->edge(eid)->srcId();
         int srcNodeLat;
         if(srcNodeId == _dfg->id()){ // connected to DFG input port
-            srcNodeLat = _dfgInputAttr[_dfg->edge(eid)->srcPortIdx()].lat;               
+            srcNodeLat = _dfgInputAttr[_dfg->edge(eid)->srcPortIdx()].lat;
         } else{
             srcNodeLat = _dfgNodeAttr[srcNodeId].lat;
         }
@@ -1090,41 +1882,179 @@ void Mapping::calEdgeLatVio(){
     int dfgSumVio = 0; // total edge latency violation
     int dfgMaxVio = 0; // max edge latency violation
     _vioDfgEdges.clear(); // DFG edges with latency violation
-    for(DFGNode* node : _dfg->topoNodes()){        
-        int nodeId = node->id();
-        int minLat = _dfgNodeAttr[nodeId].minLat; // min latency of the input ports
-        int maxLat = _dfgNodeAttr[nodeId].maxLat; // max latency of the input ports, =  latency - operation_latency
+    for(DFGNode* node : _dfg->topoNodes()){
         for(auto& elem : node->inputEdges()){
             int eid = elem.second;
-            int routeLat = _dfgEdgeAttr[eid].lat; // latNoDelay;
-            int srcNodeId = _dfg->edge(eid)->srcId();
-            int srcNodeLat;
-            if(srcNodeId != _dfg->id()){ // not connected to DFG input port
-                srcNodeLat = _dfgNodeAttr[srcNodeId].lat;                
-            } else{ // connected to DFG input port
-                srcNodeLat = _dfgInputAttr[_dfg->edge(eid)->srcPortIdx()].lat;  
-            }
-            _dfgEdgeAttr[eid].lat = maxLat - srcNodeLat; // including delay pipe latency    
-            _dfgEdgeAttr[eid].delay = maxLat - srcNodeLat - routeLat; // delay pipe latency    
-            int inPortLat = srcNodeLat + routeLat;       
-            if(inPortLat < minLat){ // need to add pass node to compensate the latency gap
-                int vio = minLat - inPortLat;
-                _dfgEdgeAttr[eid].vio = vio;
+            int vio = calEdgeLatVio(eid);
+            if(vio > 0){
                 _vioDfgEdges.push_back(eid);
                 dfgSumVio += vio;
                 dfgMaxVio = std::max(dfgMaxVio, vio);
-            } else {
-                _dfgEdgeAttr[eid].vio = 0;
             }
-        }    
+        }
     }
     _totalViolation = dfgSumVio;
     _maxViolation = dfgMaxVio;
 }
 
 
+// calculate the latency and violation of the edge connected to DFG node, return the violation
+int Mapping::calEdgeLatVio(int eid){
+    DFGEdge* edge = _dfg->edge(eid);
+    int dstNodeId = edge->dstId();
+    int minLat = _dfgNodeAttr[dstNodeId].minLat; // min latency of the input ports
+    int maxLat = _dfgNodeAttr[dstNodeId].maxLat; // max latency of the input ports, =  latency - operation_latency
+    auto& attr = _dfgEdgeAttr[eid];
+    int routeLat = attr.latNoDelay;
+    int srcNodeId = edge->srcId();
+    int srcNodeLat;
+    if(srcNodeId != _dfg->id()){ // not connected to DFG input port
+        srcNodeLat = _dfgNodeAttr[srcNodeId].lat;
+    } else{ // connected to DFG input port
+        srcNodeLat = _dfgInputAttr[edge->srcPortIdx()].lat;
+    }
+    srcNodeLat -= edge->iterDist() * _ii; // back edge: the value produced in the former iteration
+    attr.lat = maxLat - srcNodeLat; // including delay pipe latency
+    attr.delay = maxLat - srcNodeLat - routeLat; // delay pipe latency
+    int inPortLat = srcNodeLat + routeLat;
+    // need to add pass node to compensate the latency gap
+    attr.vio = (inPortLat < minLat)? (minLat - inPortLat) : 0;
+    if(edge->isBackEdge() && inPortLat > maxLat){ // the loop-carried value arrives too late for the II
+        attr.vio = inPortLat - maxLat;
+    }
+    return attr.vio;
+}
+
+
+// route DFG edge from <srcNode, srcPort> to dstNode along a path whose routing latency is in [minLat, maxLat]
+// the reged GIB output ports on the path are chained as delay registers
+// BFS over the <node, inport-index, latency> states, the path cannot pass one node twice
+bool Mapping::routeDfgEdgeWithLat(DFGEdge* edge, ADGNode* srcNode, int srcPort, ADGNode* dstNode, int minLat, int maxLat){
+    std::set<int> dstPortRange = availDstPorts(edge, dstNode);
+    if(dstPortRange.empty()){
+        return false;
+    }
+    struct VisitState{
+        int nodeId;  // node ID
+        int inPortIdx; // input port index, -1: srcNode
+        int lat; // routing latency from the srcNode to the input port
+        int parent; // index of the parent state
+        int parentOutPortIdx; // output port index of the parent node
+    };
+    std::vector<VisitState> states;
+    std::set<std::tuple<int, int, int>> visited; // <node-id, inport-index, latency>
+    states.push_back({srcNode->id(), -1, 0, -1, -1});
+    for(int i = 0; i < states.size(); i++){
+        VisitState state = states[i];
+        ADGNode* adgNode = _adg->node(state.nodeId);
+        std::vector<int> outPortIdxs;
+        if(state.inPortIdx == -1){ // srcNode
+            outPortIdxs.push_back(srcPort);
+        } else{
+            for(int outPortIdx : adgNode->in2outs(state.inPortIdx)){
+                if(routeDfgEdgePass(edge, adgNode, state.inPortIdx, outPortIdx, true)){
+                    outPortIdxs.push_back(outPortIdx);
+                }
+            }
+        }
+        for(int outPortIdx : outPortIdxs){
+            int nextLat = state.lat;
+            if(adgNode->type() == "GIB" && dynamic_cast<GIBNode*>(adgNode)->outReged(outPortIdx)){ // output port reged
+                nextLat++;
+            }
+            if(nextLat > maxLat){
+                continue;
+            }
+            for(auto& elem : adgNode->output(outPortIdx)){
+                int nextNodeId = elem.first;
+                int nextSrcPort = elem.second;
+                ADGNode* nextNode = _adg->node(nextNodeId);
+                if(nextNode == nullptr){ // connected to ADG output port
+                    continue;
+                }
+                if(nextNodeId == dstNode->id()){
+                    if(!dstPortRange.count(nextSrcPort) || nextLat < minLat){
+                        continue;
+                    }
+                    // collect the path from the dstNode to the srcNode
+                    std::vector<EdgeLinkAttr> edgeLinks;
+                    std::set<int> pathNodeIds = {nextNodeId};
+                    EdgeLinkAttr dstLink;
+                    dstLink.srcPort = nextSrcPort;
+                    dstLink.dstPort = -1;
+                    dstLink.adgNode = dstNode;
+                    edgeLinks.push_back(dstLink);
+                    bool valid = true;
+                    int outPort = outPortIdx;
+                    for(int idx = i; idx != -1; idx = states[idx].parent){
+                        if(!pathNodeIds.emplace(states[idx].nodeId).second){ // pass one node twice
+                            valid = false;
+                            break;
+                        }
+                        EdgeLinkAttr link;
+                        link.srcPort = states[idx].inPortIdx;
+                        link.dstPort = outPort;
+                        link.adgNode = _adg->node(states[idx].nodeId);
+                        edgeLinks.push_back(link);
+                        outPort = states[idx].parentOutPortIdx;
+                    }
+                    if(!valid){
+                        continue;
+                    }
+                    std::reverse(edgeLinks.begin(), edgeLinks.end());
+                    routeDfgEdgeLinks(edge, edgeLinks);
+                    return true;
+                }
+                if(nextNode->type() != "GIB" || isInPortConflict(edge, nextNodeId, nextSrcPort)){ // only route through GIB nodes
+                    continue;
+                }
+                if(!visited.emplace(std::make_tuple(nextNodeId, nextSrcPort, nextLat)).second){
+                    continue;
+                }
+                states.push_back({nextNodeId, nextSrcPort, nextLat, i, outPortIdx});
+            }
+        }
+    }
+    return false;
+}
+
+
+// reroute the GPE-to-GPE edges with latency violations through detours with more reged GIB output ports
+// the detour latency absorbs the violation beyond the max delay of the delay pipe
+// return the number of the padded edges, need to schedule the latency again
+int Mapping::padLatency(){
+    int num = 0;
+    auto vioEdgeIds = _vioDfgEdges;
+    for(int eid : vioEdgeIds){
+        DFGEdge* edge = _dfg->edge(eid);
+        if(edge->srcId() == _dfg->id() || edge->dstId() == _dfg->id() || !_dfgEdgeAttr.count(eid)){ // only pad the edges between GPE nodes
+            continue;
+        }
+        auto& attr = _dfgEdgeAttr[eid];
+        if(attr.delay < 0){ // the back edge arriving too late cannot be padded
+            continue;
+        }
+        auto& dstAttr = _dfgNodeAttr[edge->dstId()];
+        int minLat = attr.latNoDelay + attr.vio; // reach the min latency of the dst node input ports
+        int maxLat = minLat + dstAttr.maxLat - dstAttr.minLat; // not exceed the max latency of the dst node input ports
+        auto oldLinks = attr.edgeLinks;
+        ADGNode* srcNode = oldLinks.front().adgNode;
+        int srcPort = oldLinks.front().dstPort;
+        ADGNode* dstNode = oldLinks.back().adgNode;
+        unrouteDfgEdge(edge);
+        if(routeDfgEdgeWithLat(edge, srcNode, srcPort, dstNode, minLat, maxLat)){
+            num++;
+        } else{ // restore the old route
+            routeDfgEdgeLinks(edge, oldLinks);
+        }
+    }
+    return num;
+}
+
+
 // insert pass-through DFG nodes into a copy of current DFG
-void Mapping::insertPassDfgNodes(DFG* newDfg){
+// return the number of the split edges
+int Mapping::insertPassDfgNodes(DFG* newDfg){
     *newDfg = *_dfg;
     int maxNodeId = newDfg->nodes().rbegin()->first; // std::map auto sort the key
     int maxEdgeId = newDfg->edges().rbegin()->first; 
@@ -1137,7 +2067,11 @@ void Mapping::insertPassDfgNodes(DFG* newDfg){
         }
     }
     int maxInsertNodesPerEdge = 2;
+    int numSplit = 0;
     for(int eid : _vioDfgEdges){ // DFG edges with latency violation
+        if(_dfgEdgeAttr[eid].delay < 0){ // the back edge arriving too late cannot be compensated by pass-through nodes
+            continue;
+        }
         int vio = _dfgEdgeAttr[eid].vio; // maybe add multiple nodes according to vio   
         int num = std::min(maxInsertNodesPerEdge, std::max(1, vio/maxDelay));  
         DFGEdge* e = newDfg->edge(eid);
@@ -1145,6 +2079,7 @@ void Mapping::insertPassDfgNodes(DFG* newDfg){
         int dstId = e->dstId();
         int srcPortIdx = e->srcPortIdx();
         int dstPortIdx = e->dstPortIdx();
+        int iterDist = e->iterDist();
         newDfg->delEdge(eid);
         int lastId = srcId;
         int lastPort = srcPortIdx;
@@ -1153,6 +2088,10 @@ void Mapping::insertPassDfgNodes(DFG* newDfg){
             newNode->setId(++maxNodeId);
             newNode->setName("pass"+std::to_string(maxNodeId));
             newNode->setOperation("PASS");
+            DFGNode* regionNode = newDfg->node((srcId != newDfg->id())? srcId : dstId); // in the region of the split edge
+            if(regionNode->hasRegion()){
+                newNode->setRegion(regionNode->region());
+            }
             newDfg->addNode(newNode);
             DFGEdge* e1 = new DFGEdge(lastId, maxNodeId);
             e1->setId(++maxEdgeId); 
@@ -1166,6 +2105,43 @@ void Mapping::insertPassDfgNodes(DFG* newDfg){
         e2->setId(++maxEdgeId); 
         e2->setSrcPortIdx(0);
         e2->setDstPortIdx(dstPortIdx);        
+        e2->setIterDist(iterDist); // the pass-through nodes are in the iteration of the src node
         newDfg->addEdge(e2);
+        numSplit++;
+    }
+    return numSplit;
+}
+
+
+// rebind the mapping to the new DFG generated by insertPassDfgNodes, call before the current DFG is deleted
+// keep the placement and routes of the unchanged DFG nodes and edges, unroute the split edges
+void Mapping::rebindDfg(DFG* newDfg){
+    // the split edges are deleted from the new DFG, the other nodes and edges keep their IDs
+    std::vector<int> splitEdgeIds;
+    for(auto& elem : _dfgEdgeAttr){
+        if(!newDfg->edges().count(elem.first)){
+            splitEdgeIds.push_back(elem.first);
+        }
+    }
+    for(int eid : splitEdgeIds){
+        unrouteDfgEdge(_dfg->edge(eid));
+    }
+    // redirect the DFG node and edge pointers to the new DFG
+    for(auto& elem : _adgNodeAttr){
+        auto& attr = elem.second;
+        if(attr.dfgNode){
+            attr.dfgNode = newDfg->node(attr.dfgNode->id());
+        }
+        for(auto& passAttr : attr.dfgEdgePass){
+            passAttr.edge = newDfg->edge(passAttr.edge->id());
+        }
     }
+    _dfg = newDfg;
+    // schedule the new DFG from scratch
+    _schedValid = false;
+    _schedDirtyEdges.clear();
+    _schedDirtyNodes.clear();
+    _critPathNodeIds.clear();
+    _dfgNodeTopoIdx.clear();
+    _vioDfgEdges.clear();
 }
@@ -0,0 +1,379 @@
+
+#include "mapper/placement.h"
+
+
+GlobalPlacer::GlobalPlacer(ADG* adg, const std::map<std::pair<int, int>, std::vector<int>>& tiles, int maxIters) : 
+    _adg(adg), _maxIters(maxIters) {
+    for(auto& elem : tiles){
+        PlaceTile tile;
+        tile.gpeIds = elem.second;
+        tile.minX = tile.minY = 1e30;
+        tile.maxX = tile.maxY = -1e30;
+        for(int gpeId : elem.second){
+            ADGNode* gpeNode = _adg->node(gpeId);
+            tile.minX = std::min(tile.minX, (double)gpeNode->x());
+            tile.maxX = std::max(tile.maxX, (double)gpeNode->x());
+            tile.minY = std::min(tile.minY, (double)gpeNode->y());
+            tile.maxY = std::max(tile.maxY, (double)gpeNode->y());
+        }
+        _tiles.push_back(tile);
+    }
+    for(auto& elem : _adg->nodes()){
+        auto type = elem.second->type();
+        if(type == "GPE"){
+            _gpeIds.push_back(elem.first);
+        } else if(type == "IB"){
+            _ibIds.push_back(elem.first);
+        } else if(type == "OB"){
+            _obIds.push_back(elem.first);
+        }
+    }
+}
+
+
+// nearest IB/OB location to (x, y)
+std::pair<double, double> GlobalPlacer::nearestIO(const std::vector<int>& ioIds, double x, double y){
+    double minDist = 1e30;
+    std::pair<double, double> loc(x, y);
+    for(int id : ioIds){
+        ADGNode* ioNode = _adg->node(id);
+        double dist = std::abs(ioNode->x() - x) + std::abs(ioNode->y() - y);
+        if(dist < minDist){
+            minDist = dist;
+            loc = std::make_pair(ioNode->x(), ioNode->y());
+        }
+    }
+    return loc;
+}
+
+
+// build the finest graph from the DFG
+PlaceGraph GlobalPlacer::buildGraph(DFG* dfg){
+    PlaceGraph graph;
+    for(auto node : dfg->topoNodes()){
+        int id = node->id();
+        int level = 0;
+        graph.size[id] = 1;
+        graph.adj[id];
+        graph.numIn[id] = 0;
+        graph.numOut[id] = 0;
+        for(auto& elem : node->inputs()){
+            if(elem.second.first == dfg->id()){
+                graph.numIn[id]++;
+            } else{
+                level = std::max(level, (int)graph.level[elem.second.first] + 1);
+            }
+        }
+        graph.level[id] = level;
+    }
+    for(auto& elem : dfg->edges()){
+        auto edge = elem.second;
+        int srcId = edge->srcId();
+        int dstId = edge->dstId();
+        if(dstId == dfg->id()){
+            graph.numOut[srcId]++;
+        } else if(srcId != dfg->id() && srcId != dstId){
+            graph.adj[srcId][dstId]++;
+            graph.adj[dstId][srcId]++;
+        }
+    }
+    return graph;
+}
+
+
+// coarsen the graph by heavy-edge matching
+// return the coarse graph, parent: <cluster-id, coarse-cluster-id>
+PlaceGraph GlobalPlacer::coarsen(const PlaceGraph& graph, std::map<int, int>& parent){
+    PlaceGraph coarse;
+    parent.clear();
+    // visit the light clusters first to balance the cluster sizes
+    std::vector<int> ids;
+    for(auto& elem : graph.size){
+        ids.push_back(elem.first);
+    }
+    std::stable_sort(ids.begin(), ids.end(), [&](int a, int b){
+        return graph.size.at(a) < graph.size.at(b);
+    });
+    for(int id : ids){
+        if(parent.count(id)){
+            continue;
+        }
+        // match with the unmatched neighbor connected by the most edges
+        int mate = -1;
+        int maxWeight = 0;
+        for(auto& nb : graph.adj.at(id)){
+            if(parent.count(nb.first) || graph.size.at(id) + graph.size.at(nb.first) > MAX_CLUSTER_SIZE){
+                continue;
+            }
+            if(nb.second > maxWeight){
+                maxWeight = nb.second;
+                mate = nb.first;
+            }
+        }
+        parent[id] = id; // the coarse cluster takes the ID of its first member
+        coarse.size[id] = graph.size.at(id);
+        coarse.numIn[id] = graph.numIn.at(id);
+        coarse.numOut[id] = graph.numOut.at(id);
+        coarse.level[id] = graph.level.at(id) * graph.size.at(id);
+        if(mate != -1){
+            parent[mate] = id;
+            coarse.size[id] += graph.size.at(mate);
+            coarse.numIn[id] += graph.numIn.at(mate);
+            coarse.numOut[id] += graph.numOut.at(mate);
+            coarse.level[id] += graph.level.at(mate) * graph.size.at(mate);
+        }
+        coarse.level[id] /= coarse.size[id];
+        coarse.adj[id];
+    }
+    for(auto& elem : graph.adj){
+        int src = parent[elem.first];
+        for(auto& nb : elem.second){
+            int dst = parent[nb.first];
+            if(src != dst){ // internal edges disappear
+                coarse.adj[src][dst] += nb.second;
+            }
+        }
+    }
+    return coarse;
+}
+
+
+// move the clusters to the weighted center of their neighbors, IO anchors and the legal locations
+std::map<int, std::pair<double, double>> GlobalPlacer::relax(const PlaceGraph& graph, const std::map<int, std::pair<double, double>>& pos, 
+                                                             const std::map<int, std::pair<double, double>>& legalPos, double anchorWeight){
+    std::map<int, std::pair<double, double>> newPos;
+    for(auto& elem : pos){
+        int id = elem.first;
+        double x = elem.second.first;
+        double y = elem.second.second;
+        auto& legalLoc = legalPos.at(id);
+        double sumX = anchorWeight * legalLoc.first;
+        double sumY = anchorWeight * legalLoc.second;
+        double sumW = anchorWeight;
+        // attracted by the connected clusters and the nearest IO
+        for(auto& nb : graph.adj.at(id)){
+            auto& loc = pos.at(nb.first);
+            sumX += nb.second * loc.first;
+            sumY += nb.second * loc.second;
+            sumW += nb.second;
+        }
+        int numIn = graph.numIn.at(id);
+        if(numIn > 0){
+            auto loc = nearestIO(_ibIds, x, y);
+            sumX += numIn * loc.first;
+            sumY += numIn * loc.second;
+            sumW += numIn;
+        }
+        int numOut = graph.numOut.at(id);
+        if(numOut > 0){
+            auto loc = nearestIO(_obIds, x, y);
+            sumX += numOut * loc.first;
+            sumY += numOut * loc.second;
+            sumW += numOut;
+        }
+        newPos[id] = std::make_pair(sumX / sumW, sumY / sumW);
+    }
+    return newPos;
+}
+
+
+// legalize the clusters onto groups of nearby GPE nodes, ignoring the operation capability
+// return the center of each group
+std::map<int, std::pair<double, double>> GlobalPlacer::legalizeGroups(const PlaceGraph& graph, const std::map<int, std::pair<double, double>>& pos){
+    std::map<int, std::pair<double, double>> centers = pos;
+    std::set<int> usedGpeIds;
+    // the large clusters first
+    std::vector<int> ids;
+    for(auto& elem : graph.size){
+        ids.push_back(elem.first);
+    }
+    std::stable_sort(ids.begin(), ids.end(), [&](int a, int b){
+        return graph.size.at(a) > graph.size.at(b);
+    });
+    for(int id : ids){
+        auto& loc = pos.at(id);
+        // seed GPE node nearest to the location, then the free GPE nodes nearest to the seed
+        int seedId = -1;
+        double minDist = 1e30;
+        for(int gpeId : _gpeIds){
+            ADGNode* gpeNode = _adg->node(gpeId);
+            double dist = std::abs(gpeNode->x() - loc.first) + std::abs(gpeNode->y() - loc.second);
+            if(!usedGpeIds.count(gpeId) && dist < minDist){
+                minDist = dist;
+                seedId = gpeId;
+            }
+        }
+        if(seedId == -1){ // GPE nodes used up, keep the relaxed location
+            continue;
+        }
+        ADGNode* seedNode = _adg->node(seedId);
+        std::vector<std::pair<int, int>> freeGpes; // <dist, gpe-id>
+        for(int gpeId : _gpeIds){
+            if(usedGpeIds.count(gpeId)){
+                continue;
+            }
+            ADGNode* gpeNode = _adg->node(gpeId);
+            int dist = std::abs(gpeNode->x() - seedNode->x()) + std::abs(gpeNode->y() - seedNode->y());
+            freeGpes.push_back(std::make_pair(dist, gpeId));
+        }
+        std::sort(freeGpes.begin(), freeGpes.end());
+        int num = std::min((int)freeGpes.size(), graph.size.at(id));
+        double sumX = 0, sumY = 0;
+        for(int i = 0; i < num; i++){
+            ADGNode* gpeNode = _adg->node(freeGpes[i].second);
+            sumX += gpeNode->x();
+            sumY += gpeNode->y();
+            usedGpeIds.emplace(freeGpes[i].second);
+        }
+        centers[id] = std::make_pair(sumX / num, sumY / num);
+    }
+    return centers;
+}
+
+
+// legalize the DFG node locations onto the capable and free GPE nodes in the given order
+// return <dfgnode-id, gpenode-id>, empty if failed
+std::map<int, int> GlobalPlacer::legalize(DFG* dfg, const std::vector<int>& order, const std::map<int, std::pair<double, double>>& pos){
+    std::map<int, int> placement;
+    std::set<int> usedGpeIds;
+    for(int id : order){
+        auto dfgNode = dfg->node(id);
+        auto& loc = pos.at(id);
+        // assign the node to the nearest tile with free capable GPE nodes, then the nearest GPE node inside the tile
+        std::vector<std::pair<double, int>> tileDists; // <dist, tile-index>
+        for(int i = 0; i < _tiles.size(); i++){
+            auto& tile = _tiles[i];
+            double dx = std::max(0.0, std::max(tile.minX - loc.first, loc.first - tile.maxX));
+            double dy = std::max(0.0, std::max(tile.minY - loc.second, loc.second - tile.maxY));
+            tileDists.push_back(std::make_pair(dx + dy, i));
+        }
+        std::sort(tileDists.begin(), tileDists.end());
+        int bestId = -1;
+        for(auto& tileDist : tileDists){
+            double minDist = 1e30;
+            for(int gpeId : _tiles[tileDist.second].gpeIds){
+                if(usedGpeIds.count(gpeId)){
+                    continue;
+                }
+                GPENode* gpeNode = dynamic_cast<GPENode*>(_adg->node(gpeId));
+                if(!gpeNode->opCapable(dfgNode->operation()) || !dfgNode->inRegion(gpeNode->x(), gpeNode->y())){
+                    continue;
+                }
+                double dist = std::abs(gpeNode->x() - loc.first) + std::abs(gpeNode->y() - loc.second);
+                if(dist < minDist){
+                    minDist = dist;
+                    bestId = gpeId;
+                }
+            }
+            if(bestId != -1){
+                break;
+            }
+        }
+        if(bestId == -1){ // no capable GPE node left
+            return {};
+        }
+        placement[id] = bestId;
+        usedGpeIds.emplace(bestId);
+    }
+    return placement;
+}
+
+
+// total manhattan wirelength of the legal placement
+int GlobalPlacer::wirelength(DFG* dfg, const std::map<int, int>& placement){
+    int sum = 0;
+    for(auto& elem : dfg->edges()){
+        auto edge = elem.second;
+        if(edge->srcId() == dfg->id() || edge->dstId() == dfg->id()){ // IO edges are not fixed
+            continue;
+        }
+        ADGNode* srcNode = _adg->node(placement.at(edge->srcId()));
+        ADGNode* dstNode = _adg->node(placement.at(edge->dstId()));
+        sum += std::abs(srcNode->x() - dstNode->x()) + std::abs(srcNode->y() - dstNode->y());
+    }
+    return sum;
+}
+
+
+// place the DFG nodes, the DFG node IDs in order are legalized first
+// return the best legal placement, <dfgnode-id, gpenode-id>, empty if failed
+std::map<int, int> GlobalPlacer::place(DFG* dfg, const std::vector<int>& order){
+    if(_gpeIds.empty() || order.empty()){
+        return {};
+    }
+    // bounding box of the GPE array
+    double minX = 1e30, maxX = -1e30, minY = 1e30, maxY = -1e30;
+    for(int gpeId : _gpeIds){
+        ADGNode* gpeNode = _adg->node(gpeId);
+        minX = std::min(minX, (double)gpeNode->x());
+        maxX = std::max(maxX, (double)gpeNode->x());
+        minY = std::min(minY, (double)gpeNode->y());
+        maxY = std::max(maxY, (double)gpeNode->y());
+    }
+    // coarsen the DFG level by level
+    std::vector<PlaceGraph> graphs;
+    std::vector<std::map<int, int>> parents; // parents[i]: cluster in graphs[i] -> cluster in graphs[i+1]
+    graphs.push_back(buildGraph(dfg));
+    while(graphs.back().size.size() > COARSEST_SIZE){
+        std::map<int, int> parent;
+        PlaceGraph coarse = coarsen(graphs.back(), parent);
+        if(coarse.size.size() * 10 > graphs.back().size.size() * 9){ // less than 10% reduction
+            break;
+        }
+        graphs.push_back(coarse);
+        parents.push_back(parent);
+    }
+    // initial locations of the coarsest clusters: spread the topological levels along the x axis
+    double maxLevel = 1;
+    for(auto& elem : graphs.back().level){
+        maxLevel = std::max(maxLevel, elem.second);
+    }
+    std::map<int, std::pair<double, double>> pos; // <cluster-id, <x, y>>
+    for(auto& elem : graphs.back().level){
+        double x = minX + (maxX - minX) * elem.second / maxLevel;
+        pos[elem.first] = std::make_pair(x, (minY + maxY) / 2);
+    }
+    // place the coarse levels onto groups of GPE nodes, then project the locations to the finer level
+    for(int lv = graphs.size() - 1; lv > 0; lv--){
+        auto& graph = graphs[lv];
+        auto legalPos = legalizeGroups(graph, pos);
+        int iters = (lv == graphs.size() - 1)? _maxIters : _maxIters / 2; // local refinement after uncoarsening
+        for(int iter = 1; iter <= iters; iter++){
+            pos = relax(graph, pos, legalPos, 0.2 * iter);
+            legalPos = legalizeGroups(graph, pos);
+        }
+        std::map<int, std::pair<double, double>> finePos;
+        for(auto& elem : parents[lv-1]){
+            finePos[elem.first] = legalPos[elem.second];
+        }
+        pos = finePos;
+    }
+    // refine the finest level, legalize onto the capable GPE nodes
+    PlaceGraph& graph = graphs[0];
+    std::map<int, int> legal = legalize(dfg, order, pos);
+    if(legal.empty()){
+        return {};
+    }
+    std::map<int, int> best = legal;
+    int minWirelen = wirelength(dfg, legal);
+    int iters = (graphs.size() > 1)? _maxIters / 2 : _maxIters;
+    for(int iter = 1; iter <= iters; iter++){
+        std::map<int, std::pair<double, double>> legalPos;
+        for(auto& elem : legal){
+            ADGNode* gpeNode = _adg->node(elem.second);
+            legalPos[elem.first] = std::make_pair(gpeNode->x(), gpeNode->y());
+        }
+        // weight of the anchor to the last legal location, increasing to converge
+        pos = relax(graph, pos, legalPos, 0.2 * iter);
+        legal = legalize(dfg, order, pos);
+        if(legal.empty()){
+            break;
+        }
+        int wirelen = wirelength(dfg, legal);
+        if(wirelen < minWirelen){
+            minWirelen = wirelen;
+            best = legal;
+        }
+    }
+    return best;
+}
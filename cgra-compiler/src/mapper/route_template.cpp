@@ -0,0 +1,210 @@
+
+#include "mapper/route_template.h"
+
+
+// calculate the shortest path trees starting from the src port of the src node
+// each round finds the shortest path tree penalizing the GIB nodes used in the former rounds
+void RouteTemplates::calTemplates(ADGNode* srcNode, int srcPort){
+    struct VisitNodeInfo{
+        int srcNodeId;  // src node ID
+        int srcInPortIdx; // input port index of src node
+        int srcOutPortIdx; // output port index of src node
+    };
+    const int penalty = 2; // extra cost of passing through the GIB node used in the former rounds
+    int srcNodeId = srcNode->id();
+    int srcInPortIdx = -1; // GPE: no input port; IB: the input port connected to the ADG input
+    std::vector<int> srcOutPortIdxs;
+    if(srcNode->type() == "IB"){
+        srcInPortIdx = srcPort;
+        for(int outPortIdx : srcNode->in2outs(srcPort)){
+            srcOutPortIdxs.push_back(outPortIdx);
+        }
+    } else{
+        srcOutPortIdxs.push_back(srcPort);
+    }
+    auto& trees = _trees[std::make_pair(srcNodeId, srcPort)];
+    std::set<int> usedNodes; // GIB nodes used in the former rounds
+    for(int round = 0; round < _maxTemplates; round++){
+        // min cost of the visited <node-id, inport-index>
+        std::map<std::pair<int, int>, int> visitCost;
+        // cache visited node information, <<node-id, inport-index>, VisitNodeInfo>
+        std::map<std::pair<int, int>, VisitNodeInfo> visitNodes;
+        // reached dst GPE nodes, <<node-id, inport-index>, cost>
+        std::map<std::pair<int, int>, int> dstCost;
+        // <cost, <node, inport-index>>, min cost first
+        typedef std::pair<int, std::pair<ADGNode*, int>> QueElem;
+        std::priority_queue<QueElem, std::vector<QueElem>, std::greater<QueElem>> nodeQue;
+        nodeQue.push(std::make_pair(0, std::make_pair(srcNode, srcInPortIdx)));
+        while(!nodeQue.empty()){
+            int cost = nodeQue.top().first;
+            ADGNode* adgNode = nodeQue.top().second.first;
+            int inPortIdx = nodeQue.top().second.second;
+            nodeQue.pop();
+            std::vector<int> outPortIdxs;
+            if(adgNode == srcNode){
+                outPortIdxs = srcOutPortIdxs;
+            } else{
+                if(visitCost[std::make_pair(adgNode->id(), inPortIdx)] < cost){ // stale queue element
+                    continue;
+                }
+                for(int outPortIdx : adgNode->in2outs(inPortIdx)){
+                    outPortIdxs.push_back(outPortIdx);
+                }
+            }
+            for(int outPortIdx : outPortIdxs){
+                int linkCost = 1;
+                if(adgNode->type() == "GIB" && dynamic_cast<GIBNode*>(adgNode)->outReged(outPortIdx)){
+                    linkCost += 1; // output port reged
+                }
+                for(auto& elem : adgNode->output(outPortIdx)){
+                    auto nextId = elem;
+                    ADGNode* nextNode = _adg->node(nextId.first);
+                    if(nextNode == nullptr){ // connected to ADG output port
+                        continue;
+                    }
+                    auto nextNodeType = nextNode->type();
+                    int nextCost = cost + linkCost;
+                    if(nextCost > _maxCost){ // too long to be cached
+                        continue;
+                    }
+                    VisitNodeInfo info;
+                    info.srcNodeId = adgNode->id();
+                    info.srcInPortIdx = inPortIdx;
+                    info.srcOutPortIdx = outPortIdx;
+                    if(nextNodeType == "GPE"){ // get to one dst node
+                        if(nextId.first == srcNodeId){
+                            continue;
+                        }
+                        if(!dstCost.count(nextId) || dstCost[nextId] > nextCost){
+                            dstCost[nextId] = nextCost;
+                            visitNodes[nextId] = info;
+                        }
+                        continue;
+                    } else if(nextNodeType != "GIB"){ // only route through GIB nodes
+                        continue;
+                    }
+                    if(usedNodes.count(nextId.first)){
+                        nextCost += penalty;
+                    }
+                    if(visitCost.count(nextId) && visitCost[nextId] <= nextCost){
+                        continue;
+                    }
+                    visitCost[nextId] = nextCost;
+                    visitNodes[nextId] = info;
+                    nodeQue.push(std::make_pair(nextCost, std::make_pair(nextNode, nextId.second)));
+                }
+            }
+        }
+        // keep the links on the paths to the dst nodes, shared by the paths of this round
+        RouteTree tree;
+        std::map<std::pair<std::pair<int, int>, int>, int> linkIdx; // <<<node-id, inport-index>, outport-index>, link index>
+        for(auto& elem : dstCost){
+            auto routeNode = elem.first;
+            int child = -1; // link after the current one, -1: the dst node
+            while(true){
+                auto& info = visitNodes[routeNode];
+                auto prevNode = std::make_pair(info.srcNodeId, info.srcInPortIdx);
+                auto linkId = std::make_pair(prevNode, info.srcOutPortIdx);
+                auto iter = linkIdx.find(linkId);
+                int idx;
+                bool shared = (iter != linkIdx.end());
+                if(shared){
+                    idx = iter->second;
+                } else{
+                    TreeLink link;
+                    link.parent = -1;
+                    link.srcPort = info.srcInPortIdx;
+                    link.dstPort = info.srcOutPortIdx;
+                    link.adgNode = _adg->node(info.srcNodeId);
+                    idx = tree.links.size();
+                    tree.links.push_back(link);
+                    linkIdx[linkId] = idx;
+                }
+                if(child == -1){
+                    tree.dsts[elem.first] = idx;
+                } else{
+                    tree.links[child].parent = idx;
+                }
+                if(shared || info.srcNodeId == srcNodeId){ // joined the tree or got to the srcNode
+                    break;
+                }
+                usedNodes.emplace(info.srcNodeId);
+                child = idx;
+                routeNode = prevNode;
+            }
+        }
+        trees.push_back(tree);
+    }
+}
+
+
+// number of the cached paths
+int RouteTemplates::numTemplates(){
+    int num = 0;
+    for(auto& elem : _trees){
+        for(auto& tree : elem.second){
+            num += tree.dsts.size();
+        }
+    }
+    return num;
+}
+
+
+// route templates between <src-node-id, src-port-idx> and <dst-node-id, dst-inport-idx>
+// path: edge links from the src node to the dst node, same format as DFGEdgeAttr::edgeLinks
+// the paths are rebuilt from the shortest path trees, only the diverse ones are kept
+std::vector<std::vector<EdgeLinkAttr>> RouteTemplates::templates(int srcId, int srcPort, int dstId, int dstPort){
+    std::vector<std::vector<EdgeLinkAttr>> paths;
+    auto srcKey = std::make_pair(srcId, srcPort);
+    auto treeIter = _trees.find(srcKey);
+    if(treeIter == _trees.end()){
+        ADGNode* srcNode = _adg->node(srcId);
+        if(srcNode == nullptr || (srcNode->type() != "GPE" && srcNode->type() != "IB")){
+            return paths;
+        }
+        calTemplates(srcNode, srcPort);
+        treeIter = _trees.find(srcKey);
+    }
+    auto dstKey = std::make_pair(dstId, dstPort);
+    for(auto& tree : treeIter->second){
+        auto iter = tree.dsts.find(dstKey);
+        if(iter == tree.dsts.end()){
+            continue;
+        }
+        std::vector<EdgeLinkAttr> path;
+        EdgeLinkAttr dstLink;
+        dstLink.srcPort = dstPort;
+        dstLink.dstPort = -1;
+        dstLink.adgNode = _adg->node(dstId);
+        path.push_back(dstLink);
+        for(int idx = iter->second; idx != -1; idx = tree.links[idx].parent){
+            auto& treeLink = tree.links[idx];
+            EdgeLinkAttr link;
+            link.srcPort = treeLink.srcPort;
+            link.dstPort = treeLink.dstPort;
+            link.adgNode = treeLink.adgNode;
+            path.push_back(link);
+        }
+        std::reverse(path.begin(), path.end());
+        // keep diverse paths only
+        bool same = false;
+        for(auto& oldPath : paths){
+            if(oldPath.size() != path.size()){
+                continue;
+            }
+            same = true;
+            for(int i = 0; i < path.size(); i++){
+                if(oldPath[i].adgNode != path[i].adgNode || oldPath[i].srcPort != path[i].srcPort ||
+                   oldPath[i].dstPort != path[i].dstPort){
+                    same = false;
+                    break;
+                }
+            }
+            if(same) break;
+        }
+        if(!same){
+            paths.push_back(path);
+        }
+    }
+    return paths;
+}
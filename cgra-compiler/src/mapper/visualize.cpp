@@ -2,7 +2,8 @@
 #include "mapper/visualize.h"
 
 
-Graphviz::Graphviz(Mapping* mapping, std::string dirname) : _mapping(mapping), _dirname(dirname) {}
+Graphviz::Graphviz(Mapping* mapping, std::string dirname, std::string suffix) : 
+    _mapping(mapping), _dirname(dirname), _suffix(suffix) {}
 
 
 // create name for DFG node
@@ -21,7 +22,7 @@ std::string Graphviz::getDfgNodeName(int id, int idx, bool isDfgInput){
 
 
 void Graphviz::drawDFG(){
-    std::string filename = _dirname + "/mapped_dfg.dot";
+    std::string filename = _dirname + "/mapped_dfg" + _suffix + ".dot";
     std::ofstream ofs(filename);
     DFG* dfg = _mapping->getDFG();
     int dfgId = dfg->id();
@@ -52,7 +53,12 @@ void Graphviz::drawDFG(){
             int srcNodeId = input.second.first;
             std::string srcName = getDfgNodeName(srcNodeId, input.second.second);
             std::string quoteSrcName = "\"" + srcName + "\"";
-            ofs << quoteSrcName << "->" << quoteName << ";\n";
+            DFGEdge* edge = dfg->edge(node->inputEdge(input.first));
+            if(edge->isBackEdge()){ // loop-carried dependence
+                ofs << quoteSrcName << "->" << quoteName << "[style = dashed, label = \"d=" << edge->iterDist() << "\"];\n";
+            } else{
+                ofs << quoteSrcName << "->" << quoteName << ";\n";
+            }
         }
     }
     ofs << "}\n";
@@ -76,7 +82,7 @@ std::string Graphviz::getAdgNodeName(int id, int idx, bool isDfgInput){
 
 
 void Graphviz::drawADG(){
-    std::string filename = _dirname + "/mapped_adg.dot";
+    std::string filename = _dirname + "/mapped_adg" + _suffix + ".dot";
     std::ofstream ofs(filename);
     ADG* adg = _mapping->getADG();
     int adgId = adg->id();
@@ -227,7 +233,7 @@ void Graphviz::printDFGEdgePath(){
 
 // dump mapped DFG IO ports with mapped ADG IO and latency annotated
 void Graphviz::dumpDFGIO(){
-    std::string filename = _dirname + "/mapped_dfgio.txt";
+    std::string filename = _dirname + "/mapped_dfgio" + _suffix + ".txt";
     std::ofstream ofs(filename);
     ADG* adg = _mapping->getADG();
     int adgId = adg->id();
@@ -238,6 +244,9 @@ void Graphviz::dumpDFGIO(){
     //     _mapping->assignDfgIO();
     // }
     ofs << "# format: DFG-IO-Name, ADG-IO-Index, DFG-IO-Latency\n";
+    if(dfg->hasBackEdge()){ // new iteration every II cycles
+        ofs << "# II: " << _mapping->ii() << std::endl;
+    }
     for(auto& elem : dfg->inputs()){
         std::string dfgIOname = getDfgNodeName(dfgId, elem.first);
         auto& attr =  _mapping->dfgInputAttr(elem.first);
@@ -37,6 +37,11 @@ Operations::Operations(std::string& filename)
         } else{
             op_info.commutative = false;
         }
+        if(elem.contains("associative")){
+            op_info.associative = elem["associative"].get<int>() == 1;
+        } else{
+            op_info.associative = false;
+        }
         if(elem.contains("bitWidth")){
             op_info.bitWidth = elem["bitWidth"].get<int>();
         } else{
@@ -72,6 +77,7 @@ void Operations::print(){
         std::cout << "\tnumRes: " << info.numRes << std::endl;
         std::cout << "\tlatency: " << info.latency << std::endl;
         std::cout << "\tisCommutative: " << info.commutative << std::endl;
+        std::cout << "\tisAssociative: " << info.associative << std::endl;
         std::cout << "\tbitWidth: " << info.bitWidth << std::endl;
         std::cout << "\tarea: " << info.area << std::endl;
         std::cout << "\tpower: " << info.power << std::endl;
@@ -162,6 +168,16 @@ bool Operations::isCommutative(const std::string& op){
 }
 
 
+bool Operations::isAssociative(const std::string& op){
+    if(_OpInfoMap.count(op)){
+        auto op_info = _OpInfoMap[op];
+        return op_info.associative;
+    }else{
+        return false;
+    }
+}
+
+
 // if the operation is supported
 bool Operations::opCapable(const std::string& op){
     return _OpInfoMap.count(op);
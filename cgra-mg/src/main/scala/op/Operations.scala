@@ -50,29 +50,29 @@ object OPC extends Enumeration {
  */ 
 object OpInfo {
 	val OpInfoMap: Map[OPC.OPC, List[Int]] = Map(
-		// OPC -> List(NumOperands, NumRes, Latency, Operands-Commutative)
+		// OPC -> List(NumOperands, NumRes, Latency, Operands-Commutative, Associative)
 		// latency including the register outside ALU
-		OPC.PASS -> List(1, 1, 1, 0),
-		OPC.ADD  -> List(2, 1, 1, 1),
-		OPC.SUB  -> List(2, 1, 1, 0),
-		OPC.MUL  -> List(2, 1, 1, 1),
-		// OPC.DIV  -> List(2, 1, 1, 0),
-		// OPC.MOD  -> List(2, 1, 1, 0),
-		// OPC.MIN  -> List(2, 1, 1, 1),
-		OPC.AND  -> List(2, 1, 1, 1),
-		OPC.OR   -> List(2, 1, 1, 1),
-		OPC.XOR  -> List(2, 1, 1, 1),
-		OPC.SHL  -> List(2, 1, 1, 0),
-		OPC.LSHR -> List(2, 1, 1, 0),
-		OPC.ASHR -> List(2, 1, 1, 0),
-//		OPC.CSHL -> List(2, 1, 1, 0),
-//		OPC.CSHR -> List(2, 1, 1, 0),
-		OPC.EQ   -> List(2, 1, 1, 1),
-		OPC.NE   -> List(2, 1, 1, 1),
-		OPC.LT   -> List(2, 1, 1, 0),
-		OPC.LE   -> List(2, 1, 1, 0),
-//		OPC.SAT  -> List(2, 1, 1, 0),
-		OPC.SEL  -> List(3, 1, 1, 0)
+		OPC.PASS -> List(1, 1, 1, 0, 0),
+		OPC.ADD  -> List(2, 1, 1, 1, 1),
+		OPC.SUB  -> List(2, 1, 1, 0, 0),
+		OPC.MUL  -> List(2, 1, 1, 1, 1),
+		// OPC.DIV  -> List(2, 1, 1, 0, 0),
+		// OPC.MOD  -> List(2, 1, 1, 0, 0),
+		// OPC.MIN  -> List(2, 1, 1, 1, 1),
+		OPC.AND  -> List(2, 1, 1, 1, 1),
+		OPC.OR   -> List(2, 1, 1, 1, 1),
+		OPC.XOR  -> List(2, 1, 1, 1, 1),
+		OPC.SHL  -> List(2, 1, 1, 0, 0),
+		OPC.LSHR -> List(2, 1, 1, 0, 0),
+		OPC.ASHR -> List(2, 1, 1, 0, 0),
+//		OPC.CSHL -> List(2, 1, 1, 0, 0),
+//		OPC.CSHR -> List(2, 1, 1, 0, 0),
+		OPC.EQ   -> List(2, 1, 1, 1, 0),
+		OPC.NE   -> List(2, 1, 1, 1, 0),
+		OPC.LT   -> List(2, 1, 1, 0, 0),
+		OPC.LE   -> List(2, 1, 1, 0, 0),
+//		OPC.SAT  -> List(2, 1, 1, 0, 0),
+		OPC.SEL  -> List(3, 1, 1, 0, 0)
 	)
 
 	def getOperandNum(op: OPC.OPC): Int = {
@@ -91,6 +91,10 @@ object OpInfo {
 		OpInfoMap(op)(3)
 	}
 
+	def isAssociative(op: OPC.OPC): Int = {
+		OpInfoMap(op)(4)
+	}
+
 	def dumpOpInfo(filename: String): Unit = {
 		val infos = ListBuffer[Map[String, Any]]();
 		OPC.values.foreach{ op => 
@@ -100,7 +104,8 @@ object OpInfo {
 				"numOperands" -> getOperandNum(op),
 				"numRes" -> getResNum(op),
 				"latency" -> getLatency(op),
-				"commutative" -> isCommutative(op)
+				"commutative" -> isCommutative(op),
+				"associative" -> isAssociative(op)
 			)
 			infos += info
 		}